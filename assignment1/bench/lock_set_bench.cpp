@@ -0,0 +1,177 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../lockset/lock_set.hpp"
+
+// Throughput of lock_set policies against std::scoped_lock when every
+// thread repeatedly takes K random distinct locks out of NUM_LOCKS.
+//
+//   lock_set_bench [seconds_per_point] [output.csv]
+
+const size_t NUM_LOCKS = 64;
+const std::vector<int> THREAD_COUNTS{1, 2, 4, 8, 16, 32, 64};
+
+struct xorshift {
+    uint64_t s;
+    explicit xorshift(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return s;
+    }
+};
+
+template <size_t K>
+static void pick_subset(xorshift& rng, std::array<size_t, K>& ids) {
+    for (size_t i = 0; i < K; ++i) {
+        bool dup;
+        do {
+            ids[i] = rng.next() % NUM_LOCKS;
+            dup = false;
+            for (size_t j = 0; j < i; ++j) dup |= ids[j] == ids[i];
+        } while (dup);
+    }
+}
+
+// one counter per lock, padded; checked after each run
+struct alignas(64) Guarded {
+    uint64_t value = 0;
+};
+
+struct PaddedMutex {
+    alignas(64) std::mutex m;
+};
+
+struct Result {
+    uint64_t ops;
+    double ops_per_sec;
+};
+
+// Runs body(ids) with fresh random subsets on `threads` threads for `seconds`.
+template <size_t K, typename Body>
+static Result run_threads(int threads, double seconds, Body body) {
+    std::atomic<bool> start{false}, stop{false};
+    std::atomic<int> ready{0};
+    std::vector<uint64_t> ops(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            xorshift rng(t + 1);
+            std::array<size_t, K> ids;
+            uint64_t n = 0;
+            ready.fetch_add(1);
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                pick_subset(rng, ids);
+                body(ids);
+                ++n;
+            }
+            ops[t] = n;
+        });
+    }
+    while (ready.load() != threads) std::this_thread::yield();
+
+    auto t0 = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - t0;
+
+    uint64_t total = 0;
+    for (auto n : ops) total += n;
+    return Result{total, total / dur.count()};
+}
+
+// every acquisition bumps K counters; a lost update means broken exclusion
+static double checked(const char* impl, const Result& r, size_t k,
+                      const std::vector<Guarded>& counters) {
+    uint64_t sum = 0;
+    for (const auto& c : counters) sum += c.value;
+    if (sum != r.ops * k) {
+        std::cerr << impl << ": mutual exclusion violated (" << sum
+                  << " != " << r.ops * k << ")\n";
+        exit(1);
+    }
+    return r.ops_per_sec;
+}
+
+template <size_t K>
+static double bench_lock_set(lockset::acquire_policy policy, int threads, double seconds) {
+    lockset::lock_set<> set(NUM_LOCKS, policy);
+    std::vector<Guarded> counters(NUM_LOCKS);
+    Result r = run_threads<K>(threads, seconds, [&](std::array<size_t, K>& ids) {
+        lockset::lock_set<>::guard g(set, ids.data(), K);
+        for (size_t id : ids) counters[id].value++;
+    });
+    return checked(lockset::policy_name(policy), r, K, counters);
+}
+
+template <size_t K, size_t... I>
+static void scoped_lock_all(std::vector<PaddedMutex>& locks, const std::array<size_t, K>& ids,
+                            std::vector<Guarded>& counters, std::index_sequence<I...>) {
+    std::scoped_lock lk(locks[ids[I]].m...);
+    for (size_t id : ids) counters[id].value++;
+}
+
+template <size_t K>
+static double bench_scoped_lock(int threads, double seconds) {
+    std::vector<PaddedMutex> locks(NUM_LOCKS);
+    std::vector<Guarded> counters(NUM_LOCKS);
+    Result r = run_threads<K>(threads, seconds, [&](std::array<size_t, K>& ids) {
+        scoped_lock_all<K>(locks, ids, counters, std::make_index_sequence<K>{});
+    });
+    return checked("scoped_lock", r, K, counters);
+}
+
+template <size_t K>
+static void run_k(std::ofstream& ofs, double seconds) {
+    const lockset::acquire_policy policies[] = {
+        lockset::acquire_policy::ordered,
+        lockset::acquire_policy::backoff,
+        lockset::acquire_policy::arbiter,
+    };
+    for (int threads : THREAD_COUNTS) {
+        std::cout << "k=" << K << " threads=" << threads << " ... " << std::flush;
+        for (auto p : policies) {
+            double rate = bench_lock_set<K>(p, threads, seconds);
+            ofs << "lock_set_" << lockset::policy_name(p) << "," << threads << "," << K << "," << rate << "\n";
+            std::cout << lockset::policy_name(p) << "=" << (uint64_t)rate << " ";
+        }
+        double rate = bench_scoped_lock<K>(threads, seconds);
+        ofs << "scoped_lock," << threads << "," << K << "," << rate << "\n";
+        ofs.flush();
+        std::cout << "scoped_lock=" << (uint64_t)rate << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc >= 2 ? atof(argv[1]) : 0.2;
+    std::string out_csv = argc >= 3 ? argv[2] : "lock_set_results.csv";
+
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "impl,threads,k,ops_per_sec\n";
+
+    run_k<2>(ofs, seconds);
+    run_k<4>(ofs, seconds);
+
+    std::cout << "Results written to " << out_csv << "\n";
+    return 0;
+}
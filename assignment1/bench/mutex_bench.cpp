@@ -0,0 +1,147 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+
+#include <tbb/spin_mutex.h>
+
+#include "../lockset/adaptive_lock.hpp"
+#include "../program2/philo_stats.hpp"
+
+// Adaptive mutex vs pthread_mutex_t vs tbb::spin_mutex on a tiny critical
+// section, the shape of the chopstick table updates in version3/4.
+//
+// throughput: lock; ++counter; unlock as fast as possible.
+// handoff:    time from one thread's unlock to the next lock() return in a
+//             different thread, stamped inside the critical section.
+//
+//   mutex_bench [seconds_per_point] [output.csv]
+
+const std::vector<int> THREAD_COUNTS{2, 4, 8, 16, 32, 64};
+
+struct PthreadLock {
+    pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+    void lock() { pthread_mutex_lock(&m); }
+    void unlock() { pthread_mutex_unlock(&m); }
+};
+
+// state shared by the threads, only touched while holding the lock
+struct alignas(64) Shared {
+    uint64_t counter = 0;
+    int last_owner = -1;
+    uint64_t released_at = 0;
+    philo_stats::Histogram handoff_ns;
+};
+
+struct Result {
+    double ops_per_sec;
+    double handoff_mean_ns;
+    uint64_t handoff_p50_ns;
+    uint64_t handoff_p99_ns;
+};
+
+template <typename Lock, bool Timed>
+static double run(Lock& lock, Shared& shared, int threads, double seconds) {
+    std::atomic<bool> start{false}, stop{false};
+    std::atomic<int> ready{0};
+    std::vector<uint64_t> ops(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            uint64_t n = 0;
+            ready.fetch_add(1);
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                lock.lock();
+                shared.counter++;
+                if (Timed) {
+                    uint64_t now = trace::now_ns();
+                    if (shared.last_owner >= 0 && shared.last_owner != t) {
+                        shared.handoff_ns.record(now - shared.released_at);
+                    }
+                    shared.last_owner = t;
+                    shared.released_at = trace::now_ns();
+                }
+                lock.unlock();
+                ++n;
+            }
+            ops[t] = n;
+        });
+    }
+    while (ready.load() != threads) std::this_thread::yield();
+
+    auto t0 = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - t0;
+
+    uint64_t total = 0;
+    for (auto n : ops) total += n;
+    if (total != shared.counter) {
+        std::cerr << "mutual exclusion violated (" << shared.counter << " != " << total << ")\n";
+        exit(1);
+    }
+    return total / dur.count();
+}
+
+template <typename Lock>
+static Result bench(int threads, double seconds) {
+    Result r;
+    {
+        Lock lock;
+        Shared shared;
+        r.ops_per_sec = run<Lock, false>(lock, shared, threads, seconds);
+    }
+    {
+        Lock lock;
+        Shared shared;
+        run<Lock, true>(lock, shared, threads, seconds);
+        r.handoff_mean_ns = shared.handoff_ns.mean();
+        r.handoff_p50_ns = shared.handoff_ns.percentile(50);
+        r.handoff_p99_ns = shared.handoff_ns.percentile(99);
+    }
+    return r;
+}
+
+template <typename Lock>
+static void report(std::ofstream& ofs, const char* name, int threads, double seconds) {
+    Result r = bench<Lock>(threads, seconds);
+    ofs << name << "," << threads << "," << r.ops_per_sec << "," << r.handoff_mean_ns << ","
+        << r.handoff_p50_ns << "," << r.handoff_p99_ns << "\n";
+    ofs.flush();
+    std::cout << name << "=" << (uint64_t)r.ops_per_sec << "ops/s,"
+              << r.handoff_p50_ns << "ns ";
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc >= 2 ? atof(argv[1]) : 0.2;
+    std::string out_csv = argc >= 3 ? argv[2] : "mutex_results.csv";
+
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "lock,threads,ops_per_sec,handoff_mean_ns,handoff_p50_ns,handoff_p99_ns\n";
+
+    for (int threads : THREAD_COUNTS) {
+        std::cout << "threads=" << threads << " ... " << std::flush;
+        report<PthreadLock>(ofs, "pthread_mutex", threads, seconds);
+        report<tbb::spin_mutex>(ofs, "tbb_spin_mutex", threads, seconds);
+        report<lockset::adaptive_lock>(ofs, "adaptive_mutex", threads, seconds);
+        std::cout << "\n";
+    }
+
+    std::cout << "Results written to " << out_csv << "\n";
+    return 0;
+}
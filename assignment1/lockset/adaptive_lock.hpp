@@ -0,0 +1,174 @@
+#ifndef ADAPTIVE_LOCK_HPP
+#define ADAPTIVE_LOCK_HPP
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+
+#if __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lockset {
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+static inline void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE,
+            expected, nullptr, nullptr, 0);
+}
+
+static inline void futex_wake(std::atomic<uint32_t>* addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE,
+            count, nullptr, nullptr, 0);
+}
+
+// Contention counters for basic_adaptive_lock. no_stats compiles to nothing;
+// contention_stats counts with relaxed atomics, and only the acquisition
+// counter is touched on the uncontended path.
+struct no_stats {
+    void acquired() {}
+    void contended() {}
+    void spun_in() {}
+    void parked() {}
+    void woke_waiter() {}
+};
+
+struct contention_stats {
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contentions{0};   // first try_lock failed
+    std::atomic<uint64_t> spin_hits{0};     // won while spinning
+    std::atomic<uint64_t> parks{0};         // futex_wait calls
+    std::atomic<uint64_t> wakes{0};         // futex_wake calls
+
+    void acquired() { acquisitions.fetch_add(1, std::memory_order_relaxed); }
+    void contended() { contentions.fetch_add(1, std::memory_order_relaxed); }
+    void spun_in() { spin_hits.fetch_add(1, std::memory_order_relaxed); }
+    void parked() { parks.fetch_add(1, std::memory_order_relaxed); }
+    void woke_waiter() { wakes.fetch_add(1, std::memory_order_relaxed); }
+};
+
+// Spin-then-park mutex (Drepper's three-state futex mutex).
+//
+// state: 0 = free, 1 = locked, 2 = locked and somebody may sleep on it.
+// Before parking, a contended lock() spins with pause for a while; like
+// glibc's PTHREAD_MUTEX_ADAPTIVE_NP the spin budget follows a running
+// average of how long spinning actually took to succeed, so short critical
+// sections are handed over without a syscall and long ones stop wasting CPU.
+//
+// Satisfies Lockable, so it also works with std::scoped_lock / std::lock.
+template <typename Stats = no_stats>
+class basic_adaptive_lock {
+public:
+    static constexpr int MAX_SPIN = 100;
+
+    basic_adaptive_lock() = default;
+    basic_adaptive_lock(const basic_adaptive_lock&) = delete;
+    basic_adaptive_lock& operator=(const basic_adaptive_lock&) = delete;
+
+    bool try_lock() {
+        uint32_t c = 0;
+        if (state.compare_exchange_strong(c, 1, std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+            counters.acquired();
+            return true;
+        }
+        return false;
+    }
+
+    void lock() {
+        if (try_lock()) return;
+        counters.contended();
+
+        int estimate = spin_estimate.load(std::memory_order_relaxed);
+        int budget = std::min(estimate * 2 + 10, MAX_SPIN);
+
+        for (int cnt = 0; cnt < budget; ++cnt) {
+            cpu_relax();
+            if (state.load(std::memory_order_relaxed) == 0 && try_lock()) {
+                spin_estimate.store(estimate + (cnt - estimate) / 8,
+                                    std::memory_order_relaxed);
+                counters.spun_in();
+                return;
+            }
+        }
+        spin_estimate.store(estimate + (budget - estimate) / 8,
+                            std::memory_order_relaxed);
+
+        // park until the holder hands the lock back
+        uint32_t c = state.exchange(2, std::memory_order_acquire);
+        while (c != 0) {
+            counters.parked();
+            futex_wait(&state, 2);
+            c = state.exchange(2, std::memory_order_acquire);
+        }
+        counters.acquired();
+    }
+
+    void unlock() {
+        if (state.exchange(0, std::memory_order_release) == 2) {
+            counters.woke_waiter();
+            futex_wake(&state, 1);
+        }
+    }
+
+    const Stats& stats() const { return counters; }
+
+private:
+    std::atomic<uint32_t> state{0};
+    std::atomic<int> spin_estimate{0};
+    Stats counters;
+};
+
+using adaptive_lock = basic_adaptive_lock<no_stats>;
+using counted_adaptive_lock = basic_adaptive_lock<contention_stats>;
+
+} // namespace lockset
+
+// pthread-shaped interface so the lock can replace pthread_mutex_t in C-style
+// code; -DADAPTIVE_MUTEX_STATS turns on the contention counters.
+#ifdef ADAPTIVE_MUTEX_STATS
+typedef lockset::counted_adaptive_lock adaptive_mutex_t;
+#else
+typedef lockset::adaptive_lock adaptive_mutex_t;
+#endif
+
+static inline int adaptive_mutex_init(adaptive_mutex_t* m, const void* /*attr*/) {
+    new (m) adaptive_mutex_t();
+    return 0;
+}
+
+static inline int adaptive_mutex_destroy(adaptive_mutex_t* m) {
+    m->~adaptive_mutex_t();
+    return 0;
+}
+
+static inline int adaptive_mutex_lock(adaptive_mutex_t* m) {
+    m->lock();
+    return 0;
+}
+
+static inline int adaptive_mutex_trylock(adaptive_mutex_t* m) {
+    return m->try_lock() ? 0 : EBUSY;
+}
+
+static inline int adaptive_mutex_unlock(adaptive_mutex_t* m) {
+    m->unlock();
+    return 0;
+}
+
+#endif // ADAPTIVE_LOCK_HPP
@@ -0,0 +1,162 @@
+#ifndef LOCK_SET_HPP
+#define LOCK_SET_HPP
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+
+#include "adaptive_lock.hpp"
+
+// Acquire an arbitrary subset of a fixed set of locks without deadlock.
+//
+// This is the chopstick problem of program2 in library form: a caller names
+// the locks it needs (e.g. its left and right chopstick) and gets all of
+// them or none. The policy is fixed per set, because mixing policies on
+// the same locks can reintroduce a cycle.
+//
+//   ordered  - take locks in ascending index order (resource hierarchy);
+//   backoff  - block on one lock, try_lock the rest, release everything and
+//              retry starting from the lock that failed (like std::lock);
+//   arbiter  - a single arbiter lock serializes acquisition, as the waiter
+//              in version3 does, so no two threads grab locks concurrently.
+namespace lockset {
+
+enum class acquire_policy {
+    ordered,
+    backoff,
+    arbiter,
+};
+
+static inline const char* policy_name(acquire_policy p) {
+    switch (p) {
+    case acquire_policy::ordered: return "ordered";
+    case acquire_policy::backoff: return "backoff";
+    case acquire_policy::arbiter: return "arbiter";
+    }
+    return "unknown";
+}
+
+template <typename Lock = adaptive_lock>
+class lock_set {
+public:
+    static constexpr size_t MAX_SUBSET = 32;
+
+    explicit lock_set(size_t n, acquire_policy policy = acquire_policy::ordered)
+        : count(n), policy(policy), slots(new Slot[n]) {}
+
+    size_t size() const { return count; }
+    acquire_policy get_policy() const { return policy; }
+    Lock& operator[](size_t i) { return slots[i].lock; }
+
+    // ids must be distinct and smaller than size()
+    void lock(const size_t* ids, size_t k) {
+        assert(k <= MAX_SUBSET);
+        switch (policy) {
+        case acquire_policy::ordered:
+            lock_ordered(ids, k);
+            break;
+        case acquire_policy::backoff:
+            lock_backoff(ids, k);
+            break;
+        case acquire_policy::arbiter:
+            arbiter.lock.lock();
+            for (size_t i = 0; i < k; ++i) slots[ids[i]].lock.lock();
+            arbiter.lock.unlock();
+            break;
+        }
+    }
+
+    void unlock(const size_t* ids, size_t k) {
+        for (size_t i = 0; i < k; ++i) slots[ids[i]].lock.unlock();
+    }
+
+    // RAII holder for one acquisition
+    class guard {
+    public:
+        guard(lock_set& set, std::initializer_list<size_t> ids)
+            : set(set), k(ids.size()) {
+            assert(k <= MAX_SUBSET);
+            std::copy(ids.begin(), ids.end(), held);
+            set.lock(held, k);
+        }
+        guard(lock_set& set, const size_t* ids, size_t k)
+            : set(set), k(k) {
+            assert(k <= MAX_SUBSET);
+            std::copy(ids, ids + k, held);
+            set.lock(held, k);
+        }
+        ~guard() { set.unlock(held, k); }
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+    private:
+        lock_set& set;
+        size_t k;
+        size_t held[MAX_SUBSET];
+    };
+
+private:
+    // one lock per cache line so neighbouring chopsticks do not false-share
+    struct alignas(64) Slot {
+        Lock lock;
+    };
+
+    size_t count;
+    acquire_policy policy;
+    std::unique_ptr<Slot[]> slots;
+    Slot arbiter;
+
+    void lock_ordered(const size_t* ids, size_t k) {
+        // insertion sort: subsets are a handful of locks
+        size_t sorted[MAX_SUBSET];
+        for (size_t i = 0; i < k; ++i) {
+            size_t j = i;
+            for (; j > 0 && sorted[j - 1] > ids[i]; --j) sorted[j] = sorted[j - 1];
+            sorted[j] = ids[i];
+        }
+        for (size_t i = 0; i < k; ++i) slots[sorted[i]].lock.lock();
+    }
+
+    void lock_backoff(const size_t* ids, size_t k) {
+        size_t first = 0;
+        unsigned attempt = 0;
+        while (true) {
+            slots[ids[first]].lock.lock();
+            size_t failed = k;
+            for (size_t i = 1; i < k; ++i) {
+                size_t j = (first + i) % k;
+                if (!slots[ids[j]].lock.try_lock()) {
+                    failed = j;
+                    break;
+                }
+            }
+            if (failed == k) return;
+
+            // release what we got, in the same order it was taken
+            for (size_t i = 0; i < k; ++i) {
+                size_t j = (first + i) % k;
+                if (j == failed) break;
+                slots[ids[j]].lock.unlock();
+            }
+            first = failed;
+            backoff(++attempt);
+        }
+    }
+
+    static void backoff(unsigned attempt) {
+        if (attempt < 8) {
+            for (unsigned i = 0; i < (1u << attempt); ++i) cpu_relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+};
+
+} // namespace lockset
+
+#endif // LOCK_SET_HPP
@@ -0,0 +1,206 @@
+#ifndef DEADLOCK_DETECTOR_HPP
+#define DEADLOCK_DETECTOR_HPP
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+// Wait-for-graph deadlock detector for pthread mutexes.
+//
+// deadlock::lock()/unlock() wrap pthread_mutex_lock()/unlock() and only
+// publish two facts with relaxed stores: which mutex the calling thread is
+// blocked on, and which thread owns a mutex. A monitor thread periodically
+// walks that graph (every thread waits on at most one mutex, so following
+// the edges is enough to find a cycle) and reports a cycle once it has been
+// seen unchanged on consecutive scans.
+//
+// Build with -DNO_DEADLOCK_DETECTOR to compile the wrappers down to plain
+// pthread calls.
+namespace deadlock {
+
+struct ThreadRecord {
+    alignas(64) std::atomic<pthread_mutex_t*> waiting_on{nullptr};
+    std::atomic<int> id{-1};   // relabelled by register_thread after publication
+    ThreadRecord* next = nullptr;
+};
+
+struct OwnerSlot {
+    std::atomic<pthread_mutex_t*> key{nullptr};
+    std::atomic<ThreadRecord*> owner{nullptr};
+    std::atomic<const char*> name{nullptr};
+};
+
+static constexpr size_t TABLE_SIZE = 4096;   // power of two
+
+static OwnerSlot owner_table[TABLE_SIZE];
+static std::atomic<ThreadRecord*> threads{nullptr};
+static std::atomic<int> next_thread_id{0};
+
+// Slots are claimed once per mutex and never released.
+static inline OwnerSlot* slot_of(pthread_mutex_t* m, bool insert) {
+    size_t h = ((uintptr_t)m >> 4) * 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        OwnerSlot& s = owner_table[(h + i) & (TABLE_SIZE - 1)];
+        pthread_mutex_t* k = s.key.load(std::memory_order_acquire);
+        if (k == m) return &s;
+        if (k == nullptr) {
+            if (!insert) return nullptr;
+            if (s.key.compare_exchange_strong(k, m, std::memory_order_acq_rel) || k == m) {
+                return &s;
+            }
+        }
+    }
+    return nullptr;
+}
+
+static inline ThreadRecord* self() {
+    static thread_local ThreadRecord* rec = nullptr;
+    if (!rec) {
+        rec = new ThreadRecord();
+        rec->id.store(next_thread_id.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+        ThreadRecord* h = threads.load(std::memory_order_relaxed);
+        do {
+            rec->next = h;
+        } while (!threads.compare_exchange_weak(h, rec,
+                     std::memory_order_release, std::memory_order_relaxed));
+    }
+    return rec;
+}
+
+// Label the calling thread in reports (defaults to registration order).
+static inline void register_thread(int id) {
+    self()->id.store(id, std::memory_order_relaxed);
+}
+
+// Label a mutex in reports; the string must outlive the program.
+static inline void name_lock(pthread_mutex_t* m, const char* name) {
+    OwnerSlot* s = slot_of(m, true);
+    if (s) s->name.store(name, std::memory_order_relaxed);
+}
+
+#ifndef NO_DEADLOCK_DETECTOR
+
+static inline int lock(pthread_mutex_t* m) {
+    ThreadRecord* me = self();
+    OwnerSlot* s = slot_of(m, true);
+    me->waiting_on.store(m, std::memory_order_relaxed);
+    int err = pthread_mutex_lock(m);
+    me->waiting_on.store(nullptr, std::memory_order_relaxed);
+    if (err == 0 && s) s->owner.store(me, std::memory_order_relaxed);
+    return err;
+}
+
+static inline int unlock(pthread_mutex_t* m) {
+    OwnerSlot* s = slot_of(m, false);
+    if (s) s->owner.store(nullptr, std::memory_order_relaxed);
+    return pthread_mutex_unlock(m);
+}
+
+#else
+
+static inline int lock(pthread_mutex_t* m) { return pthread_mutex_lock(m); }
+static inline int unlock(pthread_mutex_t* m) { return pthread_mutex_unlock(m); }
+
+#endif
+
+struct Edge {
+    ThreadRecord* waiter;
+    pthread_mutex_t* mutex;
+    ThreadRecord* owner;
+
+    bool operator==(const Edge& o) const {
+        return waiter == o.waiter && mutex == o.mutex && owner == o.owner;
+    }
+};
+
+// One scan of the wait-for graph; returns the edges of a cycle or nothing.
+static inline std::vector<Edge> find_cycle() {
+    std::vector<Edge> edges;
+    for (ThreadRecord* r = threads.load(std::memory_order_acquire); r; r = r->next) {
+        pthread_mutex_t* m = r->waiting_on.load(std::memory_order_relaxed);
+        if (!m) continue;
+        OwnerSlot* s = slot_of(m, false);
+        ThreadRecord* o = s ? s->owner.load(std::memory_order_relaxed) : nullptr;
+        if (o && o != r) edges.push_back(Edge{r, m, o});
+    }
+
+    auto out_edge = [&](ThreadRecord* t) -> const Edge* {
+        for (const auto& e : edges) {
+            if (e.waiter == t) return &e;
+        }
+        return nullptr;
+    };
+
+    for (const auto& start : edges) {
+        // walk at most |edges| steps; a cycle must come back to start
+        std::vector<Edge> path{start};
+        ThreadRecord* cur = start.owner;
+        for (size_t step = 0; step < edges.size() && cur != start.waiter; ++step) {
+            const Edge* e = out_edge(cur);
+            if (!e) break;
+            path.push_back(*e);
+            cur = e->owner;
+        }
+        if (cur == start.waiter) return path;
+    }
+    return {};
+}
+
+static inline void report(const std::vector<Edge>& cycle, FILE* out) {
+    fprintf(out, "\nDeadlock cycle of %zu threads:\n", cycle.size());
+    for (const auto& e : cycle) {
+        OwnerSlot* s = slot_of(e.mutex, false);
+        const char* name = s ? s->name.load(std::memory_order_relaxed) : nullptr;
+        if (name) {
+            fprintf(out, "  thread %d waits for %s held by thread %d\n",
+                    e.waiter->id.load(std::memory_order_relaxed), name,
+                    e.owner->id.load(std::memory_order_relaxed));
+        } else {
+            fprintf(out, "  thread %d waits for mutex %p held by thread %d\n",
+                    e.waiter->id.load(std::memory_order_relaxed), (void*)e.mutex,
+                    e.owner->id.load(std::memory_order_relaxed));
+        }
+    }
+    fflush(out);
+}
+
+// Start the monitor thread. When a cycle persists for `confirmations`
+// consecutive scans it is reported on stdout and passed to on_deadlock().
+static inline bool start_monitor(void (*on_deadlock)(const std::vector<Edge>&),
+                                 unsigned period_ms = 50, int confirmations = 2) {
+#ifdef NO_DEADLOCK_DETECTOR
+    (void)on_deadlock; (void)period_ms; (void)confirmations;
+    return false;
+#else
+    std::thread([=]() {
+        std::vector<Edge> last;
+        int seen = 0;
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(period_ms));
+            std::vector<Edge> cycle = find_cycle();
+            if (cycle.empty()) {
+                seen = 0;
+                continue;
+            }
+            seen = (cycle == last) ? seen + 1 : 1;
+            last = cycle;
+            if (seen >= confirmations) {
+                report(cycle, stdout);
+                if (on_deadlock) on_deadlock(cycle);
+                return;
+            }
+        }
+    }).detach();
+    return true;
+#endif
+}
+
+} // namespace deadlock
+
+#endif // DEADLOCK_DETECTOR_HPP
@@ -0,0 +1,50 @@
+#ifndef PHILO_MUTEX_HPP
+#define PHILO_MUTEX_HPP
+
+#pragma once
+
+#include <cstdio>
+#include <pthread.h>
+
+#include "../lockset/adaptive_lock.hpp"
+
+// Mutex used for the chopstick table and counters in version2-4.
+//
+// Defaults to the spin-then-park adaptive mutex, whose critical sections
+// here are a few nanoseconds long. Build with -DPHILO_PTHREAD_MUTEX to go
+// back to pthread_mutex_t, and with -DADAPTIVE_MUTEX_STATS to print
+// contention counters at the end of a run.
+#ifdef PHILO_PTHREAD_MUTEX
+
+typedef pthread_mutex_t philo_mutex_t;
+
+static inline int philo_mutex_init(philo_mutex_t* m) { return pthread_mutex_init(m, NULL); }
+static inline int philo_mutex_destroy(philo_mutex_t* m) { return pthread_mutex_destroy(m); }
+static inline int philo_mutex_lock(philo_mutex_t* m) { return pthread_mutex_lock(m); }
+static inline int philo_mutex_unlock(philo_mutex_t* m) { return pthread_mutex_unlock(m); }
+static inline void philo_mutex_report(const char*, philo_mutex_t*) {}
+
+#else
+
+typedef adaptive_mutex_t philo_mutex_t;
+
+static inline int philo_mutex_init(philo_mutex_t* m) { return adaptive_mutex_init(m, NULL); }
+static inline int philo_mutex_destroy(philo_mutex_t* m) { return adaptive_mutex_destroy(m); }
+static inline int philo_mutex_lock(philo_mutex_t* m) { return adaptive_mutex_lock(m); }
+static inline int philo_mutex_unlock(philo_mutex_t* m) { return adaptive_mutex_unlock(m); }
+
+#ifdef ADAPTIVE_MUTEX_STATS
+static inline void philo_mutex_report(const char* name, philo_mutex_t* m) {
+    const auto& s = m->stats();
+    printf("%s: acquisitions=%llu contended=%llu spin_hits=%llu parks=%llu wakes=%llu\n", name,
+           (unsigned long long)s.acquisitions.load(), (unsigned long long)s.contentions.load(),
+           (unsigned long long)s.spin_hits.load(), (unsigned long long)s.parks.load(),
+           (unsigned long long)s.wakes.load());
+}
+#else
+static inline void philo_mutex_report(const char*, philo_mutex_t*) {}
+#endif
+
+#endif
+
+#endif // PHILO_MUTEX_HPP
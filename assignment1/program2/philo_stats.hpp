@@ -0,0 +1,173 @@
+#ifndef PHILO_STATS_HPP
+#define PHILO_STATS_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+
+#include "trace.hpp"
+
+// Hungry-to-eating latency and fairness metrics for the philosopher programs.
+//
+// Every philosopher owns one padded slot and is its only writer, so updates
+// are plain relaxed load/store pairs with no read-modify-write traffic.
+// The report is printed at exit() and whenever the process gets SIGUSR1.
+namespace philo_stats {
+
+// Log-linear (HDR style) histogram of nanosecond values: exact below 16,
+// then 16 sub-buckets per power of two, i.e. about 6% relative error.
+class Histogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    static int bucket_of(uint64_t v) {
+        if (v < (uint64_t)SUB_COUNT) return (int)v;
+        int e = 63 - __builtin_clzll(v);
+        int sub = (int)((v >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+        return (e - SUB_BITS + 1) * SUB_COUNT + sub;
+    }
+
+    // highest value that maps to bucket b
+    static uint64_t bucket_upper(int b) {
+        if (b < SUB_COUNT) return (uint64_t)b;
+        int e = b / SUB_COUNT + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(b % SUB_COUNT);
+        uint64_t lower = (SUB_COUNT + sub) << (e - SUB_BITS);
+        return lower + ((uint64_t)1 << (e - SUB_BITS)) - 1;
+    }
+
+    // single writer only
+    void record(uint64_t v) {
+        bump(counts[bucket_of(v)], 1);
+        bump(total, 1);
+        bump(sum, v);
+        if (v > max.load(std::memory_order_relaxed)) {
+            max.store(v, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t maximum() const { return max.load(std::memory_order_relaxed); }
+
+    double mean() const {
+        uint64_t n = count();
+        return n ? (double)sum.load(std::memory_order_relaxed) / n : 0.0;
+    }
+
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * n);
+        if (rank >= n) rank = n - 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                uint64_t hi = bucket_upper(b);
+                return hi < maximum() ? hi : maximum();
+            }
+        }
+        return maximum();
+    }
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t d) {
+        c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+    }
+};
+
+struct alignas(64) Philosopher {
+    Histogram wait_ns;
+    std::atomic<uint64_t> meals{0};
+    uint64_t hungry_since = 0;      // private to the owning thread
+};
+
+static std::vector<Philosopher>* slots = nullptr;
+
+static inline void hungry(int tid) {
+    if (!slots) return;
+    (*slots)[tid].hungry_since = trace::now_ns();
+}
+
+static inline void eating(int tid) {
+    if (!slots) return;
+    Philosopher& p = (*slots)[tid];
+    p.wait_ns.record(trace::now_ns() - p.hungry_since);
+    p.meals.store(p.meals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Jain's fairness index over meal counts: 1.0 when every philosopher ate
+// equally often, 1/n when a single one got all the meals.
+static inline double jain_index(const std::vector<uint64_t>& x) {
+    double s = 0, sq = 0;
+    for (uint64_t v : x) {
+        s += (double)v;
+        sq += (double)v * (double)v;
+    }
+    return sq > 0 ? s * s / (x.size() * sq) : 1.0;
+}
+
+static inline void dump(FILE* out) {
+    if (!slots) return;
+    std::vector<uint64_t> meals;
+    uint64_t total = 0;
+    uint64_t worst = 0;
+
+    fprintf(out, "\n%-6s %10s %10s %10s %10s %10s %10s\n", "philo", "meals",
+            "mean(us)", "p50(us)", "p99(us)", "p99.9(us)", "max(us)");
+    for (size_t i = 0; i < slots->size(); ++i) {
+        const Philosopher& p = (*slots)[i];
+        uint64_t m = p.meals.load(std::memory_order_relaxed);
+        meals.push_back(m);
+        total += m;
+        if (p.wait_ns.maximum() > worst) worst = p.wait_ns.maximum();
+        fprintf(out, "%-6zu %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n", i,
+                (unsigned long long)m, p.wait_ns.mean() / 1e3,
+                p.wait_ns.percentile(50) / 1e3, p.wait_ns.percentile(99) / 1e3,
+                p.wait_ns.percentile(99.9) / 1e3, p.wait_ns.maximum() / 1e3);
+    }
+    fprintf(out, "total meals %llu, longest wait %.2f us, Jain's fairness %.4f\n",
+            (unsigned long long)total, worst / 1e3, jain_index(meals));
+    fflush(out);
+}
+
+static inline void dump_at_exit() {
+    dump(stdout);
+}
+
+// Allocate n slots and arrange for reports at exit and on SIGUSR1.
+// Must be called before the philosopher threads are created so that they
+// inherit the blocked signal mask and SIGUSR1 reaches the reporter thread.
+static inline void init(int n) {
+    slots = new std::vector<Philosopher>(n);
+    atexit(dump_at_exit);
+
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    std::thread([set]() {
+        int sig;
+        while (sigwait(&set, &sig) == 0) {
+            dump(stdout);
+        }
+    }).detach();
+}
+
+} // namespace philo_stats
+
+#endif // PHILO_STATS_HPP
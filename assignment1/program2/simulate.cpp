@@ -0,0 +1,369 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <chrono>
+
+#include "philo_stats.hpp"
+#include "workload.hpp"
+
+// Discrete-event simulation of the philosopher strategies in virtual time.
+//
+// Lock operations take no time; only think, eat and "reach" (the gap between
+// picking up the first and the second chopstick) advance the clock. One
+// configuration costs microseconds to milliseconds of a single core, so large
+// parameter sweeps can be run here first and only the interesting points
+// re-checked with the threaded versions.
+//
+// Strategies:
+//   naive    left then right chopstick (version1, may deadlock)
+//   ordered  lower-numbered chopstick first (resource hierarchy)
+//   waiter   at most n-1 philosophers compete, then naive (version3/4)
+//   arbiter  take both chopsticks at once or wait (version2)
+//
+//   simulate [--n=5] [--strategy=all] [--think=exp:50us] [--eat=exp:50us]
+//            [--reach=zero] [--time=1s] [--seeds=1] [--max-events=10000000]
+//            [--out=simulate_results.csv]
+// --n, --strategy, --think, --eat and --reach may be repeated; every
+// combination is simulated.
+
+enum class Strategy { naive, ordered, waiter, arbiter };
+
+static const char* strategy_name(Strategy s) {
+    switch (s) {
+    case Strategy::naive:   return "naive";
+    case Strategy::ordered: return "ordered";
+    case Strategy::waiter:  return "waiter";
+    case Strategy::arbiter: return "arbiter";
+    }
+    return "unknown";
+}
+
+struct Config {
+    Strategy strategy;
+    int n;
+    workload::Spec think, eat, reach;
+    uint64_t seed;
+    double seconds;
+    uint64_t max_events;
+};
+
+struct Result {
+    double virtual_seconds = 0;
+    uint64_t events = 0;
+    bool deadlock = false;
+    philo_stats::Histogram wait_ns;
+    std::vector<uint64_t> meals;
+};
+
+class Simulation {
+public:
+    Simulation(const Config& cfg, Result& res)
+        : cfg(cfg), res(res), rng(cfg.seed), philos(cfg.n), chopsticks(cfg.n) {
+        res.meals.assign(cfg.n, 0);
+    }
+
+    void run() {
+        for (int p = 0; p < cfg.n; ++p) {
+            schedule(workload::sample(cfg.think, rng), p, HUNGRY);
+        }
+        uint64_t limit = (uint64_t)(cfg.seconds * 1e9);
+        bool out_of_time = false;
+        while (!events.empty() && res.events < cfg.max_events) {
+            Event e = events.top();
+            if (e.time > limit) {
+                out_of_time = true;
+                break;
+            }
+            events.pop();
+            now = e.time;
+            res.events++;
+            switch (e.type) {
+            case HUNGRY:  on_hungry(e.philo); break;
+            case REACHED: on_reached(e.philo); break;
+            case DONE:    on_done(e.philo); break;
+            }
+        }
+        // nothing left to happen while someone is still hungry
+        if (events.empty()) {
+            for (const auto& p : philos) res.deadlock |= p.state != EATING && p.state != THINKING;
+        }
+        res.virtual_seconds = (out_of_time ? limit : now) / 1e9;
+    }
+
+private:
+    enum Type { HUNGRY, REACHED, DONE };
+    enum State { THINKING, WANT_FIRST, REACHING, WANT_SECOND, WAIT_ADMISSION, WAIT_BOTH, EATING };
+
+    struct Event {
+        uint64_t time;
+        uint64_t seq;
+        int philo;
+        Type type;
+        bool operator>(const Event& o) const {
+            return time != o.time ? time > o.time : seq > o.seq;
+        }
+    };
+
+    struct Philosopher {
+        State state = THINKING;
+        uint64_t hungry_since = 0;
+    };
+
+    struct Chopstick {
+        int owner = -1;
+        std::deque<int> waiters;
+    };
+
+    const Config& cfg;
+    Result& res;
+    std::mt19937_64 rng;
+    std::vector<Philosopher> philos;
+    std::vector<Chopstick> chopsticks;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::deque<int> admission;      // waiter strategy
+    int admitted = 0;
+    uint64_t now = 0;
+    uint64_t seq = 0;
+
+    void schedule(uint64_t delay, int p, Type t) {
+        events.push(Event{now + delay, seq++, p, t});
+    }
+
+    int left(int p) const { return p; }
+    int right(int p) const { return (p + 1) % cfg.n; }
+    int first(int p) const {
+        return cfg.strategy == Strategy::ordered ? std::min(left(p), right(p)) : left(p);
+    }
+    int second(int p) const {
+        return cfg.strategy == Strategy::ordered ? std::max(left(p), right(p)) : right(p);
+    }
+
+    void on_hungry(int p) {
+        philos[p].hungry_since = now;
+        switch (cfg.strategy) {
+        case Strategy::naive:
+        case Strategy::ordered:
+            request_first(p);
+            break;
+        case Strategy::waiter:
+            if (admitted < cfg.n - 1) {
+                admitted++;
+                request_first(p);
+            } else {
+                philos[p].state = WAIT_ADMISSION;
+                admission.push_back(p);
+            }
+            break;
+        case Strategy::arbiter:
+            philos[p].state = WAIT_BOTH;
+            try_both(p);
+            break;
+        }
+    }
+
+    void request_first(int p) {
+        Chopstick& c = chopsticks[first(p)];
+        if (c.owner < 0) {
+            c.owner = p;
+            reach(p);
+        } else {
+            philos[p].state = WANT_FIRST;
+            c.waiters.push_back(p);
+        }
+    }
+
+    void reach(int p) {
+        philos[p].state = REACHING;
+        schedule(workload::sample(cfg.reach, rng), p, REACHED);
+    }
+
+    void on_reached(int p) {
+        Chopstick& c = chopsticks[second(p)];
+        if (c.owner < 0) {
+            c.owner = p;
+            start_eating(p);
+        } else {
+            philos[p].state = WANT_SECOND;
+            c.waiters.push_back(p);
+        }
+    }
+
+    bool try_both(int p) {
+        Chopstick& l = chopsticks[left(p)];
+        Chopstick& r = chopsticks[right(p)];
+        if (l.owner >= 0 || r.owner >= 0) return false;
+        l.owner = r.owner = p;
+        start_eating(p);
+        return true;
+    }
+
+    void start_eating(int p) {
+        philos[p].state = EATING;
+        res.wait_ns.record(now - philos[p].hungry_since);
+        res.meals[p]++;
+        if (cfg.strategy == Strategy::waiter) {
+            // version3 leaves the waiting room once both chopsticks are held
+            admitted--;
+            if (!admission.empty()) {
+                int next = admission.front();
+                admission.pop_front();
+                admitted++;
+                request_first(next);
+            }
+        }
+        schedule(workload::sample(cfg.eat, rng), p, DONE);
+    }
+
+    void release(int c) {
+        Chopstick& ch = chopsticks[c];
+        ch.owner = -1;
+        if (ch.waiters.empty()) return;
+        int w = ch.waiters.front();
+        ch.waiters.pop_front();
+        ch.owner = w;
+        if (philos[w].state == WANT_FIRST) reach(w);
+        else start_eating(w);
+    }
+
+    void on_done(int p) {
+        philos[p].state = THINKING;
+        release(left(p));
+        release(right(p));
+        if (cfg.strategy == Strategy::arbiter) {
+            int l = (p + cfg.n - 1) % cfg.n, r = (p + 1) % cfg.n;
+            // the neighbour that has been hungry longer gets the first try
+            if (philos[r].state == WAIT_BOTH &&
+                (philos[l].state != WAIT_BOTH || philos[r].hungry_since < philos[l].hungry_since)) {
+                std::swap(l, r);
+            }
+            if (philos[l].state == WAIT_BOTH) try_both(l);
+            if (philos[r].state == WAIT_BOTH) try_both(r);
+        }
+        schedule(workload::sample(cfg.think, rng), p, HUNGRY);
+    }
+};
+
+static bool starts_with(const char* s, const char* prefix, const char** value) {
+    size_t n = strlen(prefix);
+    if (strncmp(s, prefix, n) != 0) return false;
+    *value = s + n;
+    return true;
+}
+
+static bool parse_spec_arg(const char* v, std::vector<workload::Spec>& out) {
+    workload::Spec s;
+    if (!workload::parse(v, s)) {
+        fprintf(stderr, "Cannot parse duration spec '%s'\n", v);
+        return false;
+    }
+    out.push_back(s);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> ns;
+    std::vector<Strategy> strategies;
+    std::vector<workload::Spec> thinks, eats, reaches;
+    double seconds = 1.0;
+    uint64_t seeds = 1;
+    uint64_t max_events = 10000000;
+    std::string out_csv = "simulate_results.csv";
+
+    for (int i = 1; i < argc; ++i) {
+        const char* v;
+        if (starts_with(argv[i], "--n=", &v)) {
+            ns.push_back(atoi(v));
+        } else if (starts_with(argv[i], "--strategy=", &v)) {
+            std::string s = v;
+            if (s == "naive") strategies.push_back(Strategy::naive);
+            else if (s == "ordered") strategies.push_back(Strategy::ordered);
+            else if (s == "waiter") strategies.push_back(Strategy::waiter);
+            else if (s == "arbiter") strategies.push_back(Strategy::arbiter);
+            else if (s != "all") {
+                fprintf(stderr, "Unknown strategy '%s'\n", v);
+                return 1;
+            }
+        } else if (starts_with(argv[i], "--think=", &v)) {
+            if (!parse_spec_arg(v, thinks)) return 1;
+        } else if (starts_with(argv[i], "--eat=", &v)) {
+            if (!parse_spec_arg(v, eats)) return 1;
+        } else if (starts_with(argv[i], "--reach=", &v)) {
+            if (!parse_spec_arg(v, reaches)) return 1;
+        } else if (starts_with(argv[i], "--time=", &v)) {
+            double ns_total;
+            if (!workload::parse_duration(v, ns_total)) {
+                fprintf(stderr, "Cannot parse --time=%s\n", v);
+                return 1;
+            }
+            seconds = ns_total / 1e9;
+        } else if (starts_with(argv[i], "--seeds=", &v)) {
+            seeds = strtoull(v, nullptr, 10);
+        } else if (starts_with(argv[i], "--max-events=", &v)) {
+            max_events = strtoull(v, nullptr, 10);
+        } else if (starts_with(argv[i], "--out=", &v)) {
+            out_csv = v;
+        } else {
+            fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    if (ns.empty()) ns.push_back(5);
+    if (strategies.empty()) {
+        strategies = {Strategy::naive, Strategy::ordered, Strategy::waiter, Strategy::arbiter};
+    }
+    if (thinks.empty()) parse_spec_arg("exp:50us", thinks);
+    if (eats.empty()) parse_spec_arg("exp:50us", eats);
+    if (reaches.empty()) parse_spec_arg("zero", reaches);
+    for (int n : ns) {
+        if (n < 2) {
+            fprintf(stderr, "--n must be at least 2\n");
+            return 1;
+        }
+    }
+
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "strategy,n,think,eat,reach,seed,virtual_seconds,events,meals,meals_per_sec,"
+           "mean_wait_us,p50_wait_us,p99_wait_us,max_wait_us,jain,deadlock\n";
+
+    uint64_t configs = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (Strategy st : strategies)
+    for (int n : ns)
+    for (const auto& think : thinks)
+    for (const auto& eat : eats)
+    for (const auto& reach : reaches)
+    for (uint64_t seed = 1; seed <= seeds; ++seed) {
+        Config cfg{st, n, think, eat, reach, seed, seconds, max_events};
+        Result res;
+        Simulation(cfg, res).run();
+
+        uint64_t meals = 0;
+        for (auto m : res.meals) meals += m;
+        double vs = res.virtual_seconds > 0 ? res.virtual_seconds : 1e-9;
+        // specs may contain commas
+        ofs << strategy_name(st) << "," << n << ",\"" << think.text << "\",\"" << eat.text << "\",\""
+            << reach.text << "\"," << seed << "," << res.virtual_seconds << "," << res.events << ","
+            << meals << "," << meals / vs << "," << res.wait_ns.mean() / 1e3 << ","
+            << res.wait_ns.percentile(50) / 1e3 << "," << res.wait_ns.percentile(99) / 1e3 << ","
+            << res.wait_ns.maximum() / 1e3 << "," << philo_stats::jain_index(res.meals) << ","
+            << (res.deadlock ? 1 : 0) << "\n";
+        configs++;
+    }
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - t0;
+
+    std::cout << "Simulated " << configs << " configurations in " << dur.count() << "s. "
+              << "Results written to " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,213 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <time.h>
+
+// Per-thread binary event log for the philosopher programs.
+//
+// Each thread appends fixed-size events into its own single-producer ring,
+// so recording never takes a lock (printf serializes every thread on
+// stdio's internal lock). A background flusher drains all rings into a
+// binary file which tools/trace_decode turns into text or Chrome trace JSON.
+//
+// Tracing is off unless $PHILO_TRACE names the output file, so a normal run
+// costs one branch per event and writes nothing.
+namespace trace {
+
+enum State : uint32_t {
+    THINKING = 0,
+    HUNGRY   = 1,
+    EATING   = 2,
+    DEADLOCK = 3,
+    STARVING = 4,
+};
+
+static inline const char* state_name(uint32_t s) {
+    switch (s) {
+    case THINKING: return "thinking";
+    case HUNGRY:   return "hungry";
+    case EATING:   return "eating";
+    case DEADLOCK: return "deadlock";
+    case STARVING: return "starving";
+    default:       return "unknown";
+    }
+}
+
+struct Event {
+    uint64_t ts_ns;     // CLOCK_MONOTONIC
+    uint32_t tid;
+    uint32_t state;
+};
+static_assert(sizeof(Event) == 16, "trace::Event must stay 16 bytes");
+
+struct FileHeader {
+    char magic[8];      // "PHTRACE\0"
+    uint32_t version;
+    uint32_t event_size;
+};
+
+static constexpr char     MAGIC[8] = {'P', 'H', 'T', 'R', 'A', 'C', 'E', '\0'};
+static constexpr uint32_t VERSION  = 1;
+
+static inline uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// single producer (owning thread) / single consumer (flusher) ring
+struct Ring {
+    static constexpr size_t CAPACITY = 1 << 14;
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    alignas(64) std::atomic<uint64_t> head{0};     // next slot to write
+    alignas(64) std::atomic<uint64_t> tail{0};     // next slot to drain
+    alignas(64) std::atomic<uint64_t> dropped{0};
+    Ring* next = nullptr;
+    Event events[CAPACITY];
+
+    void push(const Event& e) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == CAPACITY) {
+            // never block the philosopher; the flusher is behind
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & MASK] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    size_t drain(FILE* out) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        if (h == t) return 0;
+
+        size_t n = h - t;
+        size_t first = (size_t)(t & MASK);
+        size_t chunk = n < CAPACITY - first ? n : CAPACITY - first;
+        fwrite(&events[first], sizeof(Event), chunk, out);
+        if (chunk < n) {
+            fwrite(&events[0], sizeof(Event), n - chunk, out);
+        }
+        tail.store(h, std::memory_order_release);
+        return n;
+    }
+};
+
+class Tracer {
+public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    bool start(const char* path) {
+        if (enabled.load(std::memory_order_relaxed)) return true;
+        out = fopen(path, "wb");
+        if (!out) {
+            fprintf(stderr, "trace: cannot open %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        FileHeader hdr;
+        memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+        hdr.version = VERSION;
+        hdr.event_size = sizeof(Event);
+        fwrite(&hdr, sizeof(hdr), 1, out);
+
+        stop_flag.store(false, std::memory_order_relaxed);
+        flusher = std::thread([this]() { flush_loop(); });
+        enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void stop() {
+        if (!enabled.exchange(false, std::memory_order_acq_rel)) return;
+        stop_flag.store(true, std::memory_order_release);
+        if (flusher.joinable()) flusher.join();
+
+        drain_all();
+        uint64_t dropped = 0;
+        for (Ring* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+            dropped += r->dropped.load(std::memory_order_relaxed);
+        }
+        fclose(out);
+        out = nullptr;
+        if (dropped) {
+            fprintf(stderr, "trace: %llu events dropped (flusher too slow)\n",
+                    (unsigned long long)dropped);
+        }
+    }
+
+    void record(uint32_t tid, uint32_t state) {
+        if (!enabled.load(std::memory_order_relaxed)) return;
+        local_ring().push(Event{now_ns(), tid, state});
+    }
+
+private:
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> stop_flag{false};
+    std::atomic<Ring*> rings{nullptr};
+    std::thread flusher;
+    FILE* out = nullptr;
+
+    Ring& local_ring() {
+        // rings are never freed: a thread may still append after stop()
+        static thread_local Ring* ring = nullptr;
+        if (!ring) {
+            ring = new Ring();
+            Ring* h = rings.load(std::memory_order_relaxed);
+            do {
+                ring->next = h;
+            } while (!rings.compare_exchange_weak(h, ring,
+                         std::memory_order_release, std::memory_order_relaxed));
+        }
+        return *ring;
+    }
+
+    size_t drain_all() {
+        size_t n = 0;
+        for (Ring* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+            n += r->drain(out);
+        }
+        return n;
+    }
+
+    void flush_loop() {
+        while (!stop_flag.load(std::memory_order_acquire)) {
+            if (drain_all() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+};
+
+static inline void stop() {
+    Tracer::instance().stop();
+}
+
+// Start tracing if $PHILO_TRACE is set; the log is flushed at exit().
+static inline void start() {
+    const char* path = getenv("PHILO_TRACE");
+    if (!path || !*path) return;
+    if (Tracer::instance().start(path)) {
+        atexit(stop);
+    }
+}
+
+static inline void record(uint32_t tid, uint32_t state) {
+    Tracer::instance().record(tid, state);
+}
+
+} // namespace trace
+
+#endif // TRACE_HPP
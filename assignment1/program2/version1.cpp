@@ -11,40 +11,42 @@
 #include <sys/time.h>
 #endif
 
+#include "trace.hpp"
+#include "philo_stats.hpp"
+#include "workload.hpp"
+#include "deadlock_detector.hpp"
+
 pthread_mutex_t mutex[5];
-pthread_mutex_t wait_mutex;
-volatile int count = 0;
+static const char* chopstick_names[5] = {
+    "chopstick 0", "chopstick 1", "chopstick 2", "chopstick 3", "chopstick 4"
+};
+
+void on_deadlock(const std::vector<deadlock::Edge>& cycle) {
+    for (const auto& e : cycle) {
+        trace::record(e.waiter->id.load(std::memory_order_relaxed), trace::DEADLOCK);
+    }
+    printf("\nDeadLock!\n");
+    exit(1);
+}
 
 void* thinking_and_eating(void *arg) {
     int tid = *(int*)arg;
+    deadlock::register_thread(tid);
     while (true) {
-        printf("Thread %d is thinking \n", tid);
+        trace::record(tid, trace::THINKING);
+        workload::think(tid);
 
-        if (count == 5) {
-            printf("\nDeadLock!\n");
-            exit(1);
-        }
-        printf("Thread %d is now hungry \n", tid);
-        pthread_mutex_lock(&mutex[tid]);
-        pthread_mutex_lock(&wait_mutex);
-        count++;
-        if (count == 5) {
-            printf("\nDeadLock!\n");
-            for (int i = 0; i < 5; i++) {
-                pthread_mutex_destroy(&mutex[i]);
-            }
-            exit(1);
-        }
-        pthread_mutex_unlock(&wait_mutex);
-        pthread_mutex_lock(&mutex[(tid + 1) % 5]);
+        trace::record(tid, trace::HUNGRY);
+        philo_stats::hungry(tid);
+        deadlock::lock(&mutex[tid]);
+        deadlock::lock(&mutex[(tid + 1) % 5]);
 
-        printf("Thread %d is now eating \n", tid);
+        trace::record(tid, trace::EATING);
+        philo_stats::eating(tid);
+        workload::eat(tid);
 
-        pthread_mutex_unlock(&mutex[tid]);
-        pthread_mutex_lock(&wait_mutex);
-        count--;
-        pthread_mutex_unlock(&wait_mutex);
-        pthread_mutex_unlock(&mutex[(tid + 1) % 5]);
+        deadlock::unlock(&mutex[tid]);
+        deadlock::unlock(&mutex[(tid + 1) % 5]);
         
     }
 
@@ -52,11 +54,15 @@ void* thinking_and_eating(void *arg) {
 }
 
 int main() {
+    philo_stats::init(5);
+    workload::init();
+    trace::start();
     pthread_t threads[5];
     for (int i = 0; i < 5; i++) {
         pthread_mutex_init(&mutex[i], NULL);
+        deadlock::name_lock(&mutex[i], chopstick_names[i]);
     }
-    pthread_mutex_init(&wait_mutex, NULL);
+    deadlock::start_monitor(on_deadlock);
 
     for (int i = 0; i < 5; i++) {
         int *ptr = (int *)malloc(sizeof(int));
@@ -78,7 +84,6 @@ int main() {
     for (int i = 0; i < 5; i++) {
         pthread_mutex_destroy(&mutex[i]);
     }
-    pthread_mutex_destroy(&wait_mutex);
 
     return 0;
 }
\ No newline at end of file
@@ -11,7 +11,12 @@
 #include <sys/time.h>
 #endif
 
-pthread_mutex_t mutex;
+#include "trace.hpp"
+#include "philo_stats.hpp"
+#include "workload.hpp"
+#include "philo_mutex.hpp"
+
+philo_mutex_t mutex;
 static std::vector<bool> chopsticks(5, true);
 
 double get_time_sec() {
@@ -24,33 +29,38 @@ void* thinking_and_eating(void *arg) {
     int tid = *(int*)arg;
     double start_time, end_time;
     while (true) {
-        printf("Thread %d is thinking \n", tid);
+        trace::record(tid, trace::THINKING);
+        workload::think(tid);
         
-        printf("Thread %d is now hungry \n", tid);
+        trace::record(tid, trace::HUNGRY);
+        philo_stats::hungry(tid);
         start_time = get_time_sec();
 
-        pthread_mutex_lock(&mutex);
+        philo_mutex_lock(&mutex);
         while (!chopsticks[tid] || !chopsticks[(tid + 1) % 5]) {
-            pthread_mutex_unlock(&mutex);
+            philo_mutex_unlock(&mutex);
 
             end_time = get_time_sec();
             if (end_time - start_time > 1.0) {
+                trace::record(tid, trace::STARVING);
                 printf("\nThread %d is starving!\n", tid);
                 exit(1);
             }
             
-            pthread_mutex_lock(&mutex);
+            philo_mutex_lock(&mutex);
         }
 
         chopsticks[tid] = false;
         chopsticks[(tid + 1) % 5] = false;
-        pthread_mutex_unlock(&mutex);
+        philo_mutex_unlock(&mutex);
         
-        printf("Thread %d is now eating \n", tid);
-        pthread_mutex_lock(&mutex);
+        trace::record(tid, trace::EATING);
+        philo_stats::eating(tid);
+        workload::eat(tid);
+        philo_mutex_lock(&mutex);
         chopsticks[tid] = true;
         chopsticks[(tid + 1) % 5] = true;
-        pthread_mutex_unlock(&mutex);
+        philo_mutex_unlock(&mutex);
         
     }
 
@@ -58,8 +68,11 @@ void* thinking_and_eating(void *arg) {
 }
 
 int main() {
+    philo_stats::init(5);
+    workload::init();
+    trace::start();
     pthread_t threads[5];
-    pthread_mutex_init(&mutex, NULL);
+    philo_mutex_init(&mutex);
 
     for (int i = 0; i < 5; i++) {
         int *ptr = (int *)malloc(sizeof(int));
@@ -67,7 +80,7 @@ int main() {
         int err = pthread_create(&threads[i], NULL, thinking_and_eating, ptr);
         if (err != 0) {
             printf("Can't create thread %d :[%s]\n", i, strerror(err));
-            pthread_mutex_destroy(&mutex);
+            philo_mutex_destroy(&mutex);
             exit(1);
         }
     }
@@ -75,7 +88,7 @@ int main() {
     for (int i = 0; i < 5; i++) {
         pthread_join(threads[i], NULL);
     }
-    pthread_mutex_destroy(&mutex);
+    philo_mutex_destroy(&mutex);
 
     return 0;
 }
\ No newline at end of file
@@ -12,10 +12,15 @@
 #include <sys/time.h>
 #endif
 
+#include "trace.hpp"
+#include "philo_stats.hpp"
+#include "workload.hpp"
+#include "philo_mutex.hpp"
+
 volatile bool exit_flag = false;
 
 volatile int count = 0;
-pthread_mutex_t mutex, wait_mutex, exit_mutex;
+philo_mutex_t mutex, wait_mutex, exit_mutex;
 static std::vector<bool> chopsticks(5, true);
 
 
@@ -26,39 +31,43 @@ void* thinking_and_eating(void *arg) {
             break;
         }
 
-        printf("Thread %d is thinking \n", tid);
+        trace::record(tid, trace::THINKING);
+        workload::think(tid);
 
-        printf("Thread %d is now hungry \n", tid);
+        trace::record(tid, trace::HUNGRY);
+        philo_stats::hungry(tid);
 
-        pthread_mutex_lock(&wait_mutex);
+        philo_mutex_lock(&wait_mutex);
         while (count == 4) {
-            pthread_mutex_unlock(&wait_mutex);
+            philo_mutex_unlock(&wait_mutex);
             
-            pthread_mutex_lock(&wait_mutex);
+            philo_mutex_lock(&wait_mutex);
         }
         count++;
-        pthread_mutex_unlock(&wait_mutex);
+        philo_mutex_unlock(&wait_mutex);
         
-        pthread_mutex_lock(&mutex);
+        philo_mutex_lock(&mutex);
         while (!chopsticks[tid] || !chopsticks[(tid + 1) % 5]) {
             
-            pthread_mutex_unlock(&mutex);
+            philo_mutex_unlock(&mutex);
             // busy wait
-            pthread_mutex_lock(&mutex);
+            philo_mutex_lock(&mutex);
         }
         chopsticks[tid] = false;
         chopsticks[(tid + 1) % 5] = false;
-        pthread_mutex_unlock(&mutex);
-        pthread_mutex_lock(&wait_mutex);
+        philo_mutex_unlock(&mutex);
+        philo_mutex_lock(&wait_mutex);
         count--;
-        pthread_mutex_unlock(&wait_mutex);
+        philo_mutex_unlock(&wait_mutex);
         
-        printf("Thread %d is now eating \n", tid);
+        trace::record(tid, trace::EATING);
+        philo_stats::eating(tid);
+        workload::eat(tid);
 
-        pthread_mutex_lock(&mutex);
+        philo_mutex_lock(&mutex);
         chopsticks[tid] = true;
         chopsticks[(tid + 1) % 5] = true;
-        pthread_mutex_unlock(&mutex);
+        philo_mutex_unlock(&mutex);
         
     }
 
@@ -66,10 +75,13 @@ void* thinking_and_eating(void *arg) {
 }
 
 int main() {
+    philo_stats::init(5);
+    workload::init();
+    trace::start();
     pthread_t threads[5];
-    pthread_mutex_init(&mutex, NULL);
-    pthread_mutex_init(&wait_mutex, NULL);
-    pthread_mutex_init(&exit_mutex, NULL);
+    philo_mutex_init(&mutex);
+    philo_mutex_init(&wait_mutex);
+    philo_mutex_init(&exit_mutex);
 
     for (int i = 0; i < 5; i++) {
         int *ptr = (int *)malloc(sizeof(int));
@@ -77,9 +89,9 @@ int main() {
         int err = pthread_create(&threads[i], NULL, thinking_and_eating, ptr);
         if (err != 0) {
             printf("Can't create thread %d :[%s]\n", i, strerror(err));
-            pthread_mutex_destroy(&mutex);
-            pthread_mutex_destroy(&wait_mutex);
-            pthread_mutex_destroy(&exit_mutex);
+            philo_mutex_destroy(&mutex);
+            philo_mutex_destroy(&wait_mutex);
+            philo_mutex_destroy(&exit_mutex);
             exit(1);
         }
     }
@@ -90,9 +102,9 @@ int main() {
             input[strcspn(input, "\n")] = 0; 
 
             if (strcmp(input, "n") == 0) {
-                pthread_mutex_lock(&exit_mutex);
+                philo_mutex_lock(&exit_mutex);
                 exit_flag = true;
-                pthread_mutex_unlock(&exit_mutex);
+                philo_mutex_unlock(&exit_mutex);
                 break;
             }
         }
@@ -102,9 +114,12 @@ int main() {
         pthread_join(threads[i], NULL);
     }
 
-    pthread_mutex_destroy(&mutex);
-    pthread_mutex_destroy(&wait_mutex);
-    pthread_mutex_destroy(&exit_mutex);
+    philo_mutex_report("mutex", &mutex);
+    philo_mutex_report("wait_mutex", &wait_mutex);
+
+    philo_mutex_destroy(&mutex);
+    philo_mutex_destroy(&wait_mutex);
+    philo_mutex_destroy(&exit_mutex);
 
     return 0;
 }
\ No newline at end of file
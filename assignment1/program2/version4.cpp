@@ -12,12 +12,17 @@
 #include <sys/time.h>
 #endif
 
+#include "trace.hpp"
+#include "philo_stats.hpp"
+#include "workload.hpp"
+#include "philo_mutex.hpp"
+
 int n;
 
 volatile bool exit_flag = false;
 
 volatile int count = 0;
-pthread_mutex_t mutex, wait_mutex, exit_mutex;
+philo_mutex_t mutex, wait_mutex, exit_mutex;
 static std::vector<bool> chopsticks;
 
 void* thinking_and_eating(void *arg) {
@@ -27,39 +32,43 @@ void* thinking_and_eating(void *arg) {
             break;
         }
 
-        printf("Thread %d is thinking \n", tid);
+        trace::record(tid, trace::THINKING);
+        workload::think(tid);
 
-        printf("Thread %d is now hungry \n", tid);
+        trace::record(tid, trace::HUNGRY);
+        philo_stats::hungry(tid);
 
-        pthread_mutex_lock(&wait_mutex);
+        philo_mutex_lock(&wait_mutex);
         while (count == n-1) {
-            pthread_mutex_unlock(&wait_mutex);
+            philo_mutex_unlock(&wait_mutex);
             
-            pthread_mutex_lock(&wait_mutex);
+            philo_mutex_lock(&wait_mutex);
         }
         count++;
-        pthread_mutex_unlock(&wait_mutex);
+        philo_mutex_unlock(&wait_mutex);
         
-        pthread_mutex_lock(&mutex);
+        philo_mutex_lock(&mutex);
         while (!chopsticks[tid] || !chopsticks[(tid + 1) % 5]) {
             
-            pthread_mutex_unlock(&mutex);
+            philo_mutex_unlock(&mutex);
             // busy wait
-            pthread_mutex_lock(&mutex);
+            philo_mutex_lock(&mutex);
         }
         chopsticks[tid] = false;
         chopsticks[(tid + 1) % 5] = false;
-        pthread_mutex_unlock(&mutex);
-        pthread_mutex_lock(&wait_mutex);
+        philo_mutex_unlock(&mutex);
+        philo_mutex_lock(&wait_mutex);
         count--;
-        pthread_mutex_unlock(&wait_mutex);
+        philo_mutex_unlock(&wait_mutex);
         
-        printf("Thread %d is now eating \n", tid);
+        trace::record(tid, trace::EATING);
+        philo_stats::eating(tid);
+        workload::eat(tid);
 
-        pthread_mutex_lock(&mutex);
+        philo_mutex_lock(&mutex);
         chopsticks[tid] = true;
         chopsticks[(tid + 1) % 5] = true;
-        pthread_mutex_unlock(&mutex);
+        philo_mutex_unlock(&mutex);
         
     }
 
@@ -70,10 +79,13 @@ int main() {
     printf("Enter number of philosophers: ");
 
     scanf("%d", &n);
+    philo_stats::init(n);
+    workload::init();
+    trace::start();
     pthread_t threads[n];
-    pthread_mutex_init(&mutex, NULL);
-    pthread_mutex_init(&wait_mutex, NULL);
-    pthread_mutex_init(&exit_mutex, NULL);
+    philo_mutex_init(&mutex);
+    philo_mutex_init(&wait_mutex);
+    philo_mutex_init(&exit_mutex);
     chopsticks.resize(n, true);
 
     for (int i = 0; i < n; i++) {
@@ -82,9 +94,9 @@ int main() {
         int err = pthread_create(&threads[i], NULL, thinking_and_eating, ptr);
         if (err != 0) {
             printf("Can't create thread %d :[%s]\n", i, strerror(err));
-            pthread_mutex_destroy(&mutex);
-            pthread_mutex_destroy(&wait_mutex);
-            pthread_mutex_destroy(&exit_mutex);
+            philo_mutex_destroy(&mutex);
+            philo_mutex_destroy(&wait_mutex);
+            philo_mutex_destroy(&exit_mutex);
             exit(1);
         }
     }
@@ -95,9 +107,9 @@ int main() {
             input[strcspn(input, "\n")] = 0; 
 
             if (strcmp(input, "n") == 0) {
-                pthread_mutex_lock(&exit_mutex);
+                philo_mutex_lock(&exit_mutex);
                 exit_flag = true;
-                pthread_mutex_unlock(&exit_mutex);
+                philo_mutex_unlock(&exit_mutex);
                 break;
             }
         }
@@ -107,9 +119,12 @@ int main() {
         pthread_join(threads[i], NULL);
     }
 
-    pthread_mutex_destroy(&mutex);
-    pthread_mutex_destroy(&wait_mutex);
-    pthread_mutex_destroy(&exit_mutex);
+    philo_mutex_report("mutex", &mutex);
+    philo_mutex_report("wait_mutex", &wait_mutex);
+
+    philo_mutex_destroy(&mutex);
+    philo_mutex_destroy(&wait_mutex);
+    philo_mutex_destroy(&exit_mutex);
 
     return 0;
 }
\ No newline at end of file
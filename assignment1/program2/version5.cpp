@@ -0,0 +1,429 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <coroutine>
+#include <utility>
+
+#include "philo_stats.hpp"
+
+// Philosophers as C++20 coroutines on a fixed pool of worker threads.
+//
+// Each philosopher is a task that co_awaits its chopsticks; a blocked task
+// costs one queue entry instead of a kernel thread, so 100k+ philosophers
+// fit in a handful of workers. Workers own a Chase-Lev deque and steal from
+// each other when idle. The same workload can be run with one OS thread per
+// philosopher to measure scheduler overhead against the kernel.
+//
+//   version5 [philosophers] [workers] [seconds] [coro|threads]
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+// Chase-Lev work-stealing deque (fixed capacity, C11 formulation by Le et al.)
+class WorkDeque {
+public:
+    explicit WorkDeque(size_t capacity_pow2)
+        : mask(capacity_pow2 - 1), buffer(new std::atomic<void*>[capacity_pow2]) {}
+    ~WorkDeque() { delete[] buffer; }
+
+    // owner only
+    void push(void* item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        buffer[b & mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only
+    void* pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        void* item = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // last item: race against thieves
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread
+    void* steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        void* item = buffer[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    alignas(64) int64_t mask;
+    std::atomic<void*>* buffer;
+};
+
+class Scheduler {
+public:
+    Scheduler(int workers, size_t max_tasks) {
+        size_t cap = 1;
+        while (cap < max_tasks + 1) cap <<= 1;
+        for (int i = 0; i < workers; ++i) {
+            deques.emplace_back(new WorkDeque(cap));
+        }
+        stats.resize(workers);
+        yielded.resize(workers);
+    }
+
+    ~Scheduler() {
+        for (auto* d : deques) delete d;
+    }
+
+    // Called before run(): spreads tasks round-robin over the workers.
+    void spawn(std::coroutine_handle<> h) {
+        deques[next_spawn++ % deques.size()]->push(h.address());
+        live.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Make h runnable; from a worker it goes to that worker's own deque.
+    void schedule(std::coroutine_handle<> h) {
+        deques[current_worker]->push(h.address());
+    }
+
+    // The deque is LIFO for its owner, so a yielding task would be resumed
+    // again right away. Yielded tasks wait in a private FIFO instead and are
+    // moved into the deque (oldest on the bottom) once it runs dry.
+    void schedule_yield(std::coroutine_handle<> h) {
+        yielded[current_worker].items.push_back(h.address());
+    }
+
+    void task_finished() {
+        live.fetch_sub(1, std::memory_order_release);
+    }
+
+    void run() {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < deques.size(); ++i) {
+            threads.emplace_back([this, i]() { worker_loop((int)i); });
+        }
+        for (auto& t : threads) t.join();
+    }
+
+    uint64_t total_resumes() const {
+        uint64_t n = 0;
+        for (const auto& s : stats) n += s.resumes;
+        return n;
+    }
+
+    uint64_t total_steals() const {
+        uint64_t n = 0;
+        for (const auto& s : stats) n += s.steals;
+        return n;
+    }
+
+    auto yield() {
+        struct Awaiter {
+            Scheduler& s;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { s.schedule_yield(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+private:
+    struct alignas(64) WorkerStats {
+        uint64_t resumes = 0;
+        uint64_t steals = 0;
+    };
+
+    struct alignas(64) YieldQueue {
+        std::vector<void*> items;
+    };
+
+    std::vector<WorkDeque*> deques;
+    std::vector<WorkerStats> stats;
+    std::vector<YieldQueue> yielded;
+    std::atomic<int64_t> live{0};
+    size_t next_spawn = 0;
+    static thread_local int current_worker;
+
+    void worker_loop(int id) {
+        current_worker = id;
+        uint64_t rng = id * 0x9E3779B97F4A7C15ull + 1;
+        WorkerStats& st = stats[id];
+        int idle = 0;
+
+        while (live.load(std::memory_order_acquire) > 0) {
+            void* item = deques[id]->pop();
+            if (!item && !yielded[id].items.empty()) {
+                auto& items = yielded[id].items;
+                for (size_t i = items.size(); i-- > 0;) deques[id]->push(items[i]);
+                items.clear();
+                continue;
+            }
+            if (!item && deques.size() > 1) {
+                rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+                size_t victim = rng % deques.size();
+                if ((int)victim != id) {
+                    item = deques[victim]->steal();
+                    if (item) st.steals++;
+                }
+            }
+            if (!item) {
+                if (++idle < 64) cpu_relax();
+                else { std::this_thread::yield(); idle = 0; }
+                continue;
+            }
+            idle = 0;
+            st.resumes++;
+            std::coroutine_handle<>::from_address(item).resume();
+        }
+    }
+};
+
+thread_local int Scheduler::current_worker = 0;
+
+// Fire-and-forget coroutine; the frame frees itself when the body returns.
+struct Task {
+    struct promise_type {
+        Task get_return_object() {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Awaitable chopstick (lock-free async mutex, as in cppcoro).
+//
+// state is NOT_LOCKED, 0 (locked, no new waiters) or the head of a stack of
+// newly arrived waiters. The holder moves that stack into its private FIFO
+// and on unlock hands ownership straight to the oldest waiter.
+class Chopstick {
+public:
+    struct Awaiter {
+        Chopstick& c;
+        std::coroutine_handle<> handle;
+        Awaiter* next = nullptr;
+
+        bool await_ready() noexcept { return c.try_lock(); }
+
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            handle = h;
+            uintptr_t old = c.state.load(std::memory_order_acquire);
+            while (true) {
+                if (old == NOT_LOCKED) {
+                    if (c.state.compare_exchange_weak(old, 0, std::memory_order_acquire,
+                                                      std::memory_order_relaxed)) {
+                        return false;   // got it, keep running
+                    }
+                } else {
+                    next = reinterpret_cast<Awaiter*>(old);
+                    if (c.state.compare_exchange_weak(old, reinterpret_cast<uintptr_t>(this),
+                                                      std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    explicit Chopstick(Scheduler* s = nullptr) : sched(s) {}
+
+    bool try_lock() {
+        uintptr_t old = NOT_LOCKED;
+        return state.compare_exchange_strong(old, 0, std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    Awaiter lock() { return Awaiter{*this, {}}; }
+
+    void unlock() {
+        Awaiter* w = waiters;
+        if (!w) {
+            uintptr_t old = 0;
+            if (state.compare_exchange_strong(old, NOT_LOCKED, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+                return;
+            }
+            // new waiters arrived: reverse their stack into FIFO order
+            old = state.exchange(0, std::memory_order_acquire);
+            Awaiter* s = reinterpret_cast<Awaiter*>(old);
+            while (s) {
+                Awaiter* n = s->next;
+                s->next = w;
+                w = s;
+                s = n;
+            }
+        }
+        waiters = w->next;
+        sched->schedule(w->handle);   // ownership passes to w
+    }
+
+    void set_scheduler(Scheduler* s) { sched = s; }
+
+private:
+    static constexpr uintptr_t NOT_LOCKED = 1;
+    alignas(64) std::atomic<uintptr_t> state{NOT_LOCKED};
+    Awaiter* waiters = nullptr;     // owned by the current holder
+    Scheduler* sched;
+};
+
+struct alignas(64) Meals {
+    uint64_t count = 0;
+};
+
+static std::atomic<bool> stop_flag{false};
+
+Task philosopher(Scheduler& sched, std::vector<Chopstick>& chopsticks,
+                 std::vector<Meals>& meals, int tid, int n) {
+    int first = tid, second = (tid + 1) % n;
+    if (first > second) std::swap(first, second);
+
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        // thinking
+        co_await sched.yield();
+
+        // hungry
+        co_await chopsticks[first].lock();
+        co_await chopsticks[second].lock();
+
+        // eating
+        meals[tid].count++;
+
+        chopsticks[second].unlock();
+        chopsticks[first].unlock();
+    }
+    sched.task_finished();
+}
+
+static void report(const char* mode, int n, int workers, double secs,
+                   const std::vector<Meals>& meals, uint64_t resumes, uint64_t steals) {
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    for (const auto& m : meals) {
+        counts.push_back(m.count);
+        total += m.count;
+    }
+    printf("mode=%s philosophers=%d workers=%d seconds=%.3f\n", mode, n, workers, secs);
+    printf("meals=%llu meals/s=%.0f Jain's fairness=%.4f\n",
+           (unsigned long long)total, total / secs, philo_stats::jain_index(counts));
+    if (resumes) {
+        printf("resumes=%llu (%.1f ns each) steals=%llu\n", (unsigned long long)resumes,
+               secs * 1e9 * workers / resumes, (unsigned long long)steals);
+    }
+}
+
+static void run_coroutines(int n, int workers, double seconds) {
+    Scheduler sched(workers, n);
+    std::vector<Chopstick> chopsticks(n);
+    for (auto& c : chopsticks) c.set_scheduler(&sched);
+    std::vector<Meals> meals(n);
+
+    for (int i = 0; i < n; ++i) {
+        sched.spawn(philosopher(sched, chopsticks, meals, i, n).handle);
+    }
+
+    std::thread timer([seconds]() {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop_flag.store(true, std::memory_order_relaxed);
+    });
+    auto t0 = std::chrono::steady_clock::now();
+    sched.run();
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - t0;
+    timer.join();
+
+    report("coro", n, workers, dur.count(), meals, sched.total_resumes(), sched.total_steals());
+}
+
+// Baseline: one kernel thread per philosopher, std::mutex chopsticks.
+static void run_threads(int n, double seconds) {
+    struct alignas(64) PaddedMutex {
+        std::mutex m;
+    };
+    std::vector<PaddedMutex> chopsticks(n);
+    std::vector<Meals> meals(n);
+    std::vector<std::thread> threads;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < n; ++tid) {
+        try {
+            threads.emplace_back([&, tid]() {
+                int first = tid, second = (tid + 1) % n;
+                if (first > second) std::swap(first, second);
+                while (!stop_flag.load(std::memory_order_relaxed)) {
+                    std::this_thread::yield();
+                    std::scoped_lock lk(chopsticks[first].m, chopsticks[second].m);
+                    meals[tid].count++;
+                }
+            });
+        } catch (const std::system_error& e) {
+            printf("Can't create thread %d :[%s]\n", tid, e.what());
+            stop_flag.store(true);
+            for (auto& t : threads) t.join();
+            exit(1);
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop_flag.store(true, std::memory_order_relaxed);
+    for (auto& t : threads) t.join();
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - t0;
+
+    report("threads", n, n, dur.count(), meals, 0, 0);
+}
+
+int main(int argc, char** argv) {
+    int n = argc >= 2 ? atoi(argv[1]) : 100000;
+    int workers = argc >= 3 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    double seconds = argc >= 4 ? atof(argv[3]) : 1.0;
+    std::string mode = argc >= 5 ? argv[4] : "coro";
+
+    if (n < 2 || workers < 1 || seconds <= 0) {
+        printf("usage: %s [philosophers>=2] [workers>=1] [seconds] [coro|threads]\n", argv[0]);
+        return 1;
+    }
+
+    if (mode == "coro") {
+        run_coroutines(n, workers, seconds);
+    } else if (mode == "threads") {
+        run_threads(n, seconds);
+    } else {
+        printf("Unknown mode '%s' (expected coro or threads)\n", mode.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "trace.hpp"
+
+// Think/eat workload model for the philosopher programs.
+//
+// A duration is described as "<dist>:<params>" with time suffixes ns, us,
+// ms or s (plain numbers are nanoseconds):
+//
+//   zero                      no work (the default)
+//   const:20us                always 20us
+//   uniform:10us,50us         uniform in [10us, 50us)
+//   exp:30us                  exponential with mean 30us
+//   normal:50us,10us          normal(mean, stddev), clamped at 0
+//   lognormal:50us,0.5        log-normal with the given mean and sigma
+//
+// The threaded programs read $PHILO_THINK and $PHILO_EAT and burn CPU for
+// the sampled time; simulate uses the same specs in virtual time.
+namespace workload {
+
+enum class Dist {
+    zero,
+    constant,
+    uniform,
+    exponential,
+    normal,
+    lognormal,
+};
+
+struct Spec {
+    Dist dist = Dist::zero;
+    double a = 0;       // ns, except lognormal sigma
+    double b = 0;
+    std::string text = "zero";
+};
+
+static inline bool parse_duration(const char* s, double& ns) {
+    char* end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0) return false;
+    if (*end == 0 || strcmp(end, "ns") == 0) ns = v;
+    else if (strcmp(end, "us") == 0) ns = v * 1e3;
+    else if (strcmp(end, "ms") == 0) ns = v * 1e6;
+    else if (strcmp(end, "s") == 0) ns = v * 1e9;
+    else return false;
+    return true;
+}
+
+// Returns false (and leaves spec untouched) on a malformed description.
+static inline bool parse(const std::string& text, Spec& spec) {
+    Spec out;
+    out.text = text;
+    size_t colon = text.find(':');
+    std::string name = text.substr(0, colon);
+    std::string args = colon == std::string::npos ? "" : text.substr(colon + 1);
+    std::string first = args.substr(0, args.find(','));
+    std::string second = args.find(',') == std::string::npos ? "" : args.substr(args.find(',') + 1);
+
+    if (name == "zero") {
+        out.dist = Dist::zero;
+    } else if (name == "const") {
+        out.dist = Dist::constant;
+        if (!parse_duration(first.c_str(), out.a)) return false;
+    } else if (name == "uniform") {
+        out.dist = Dist::uniform;
+        if (!parse_duration(first.c_str(), out.a) || !parse_duration(second.c_str(), out.b) ||
+            out.b < out.a) return false;
+    } else if (name == "exp") {
+        out.dist = Dist::exponential;
+        if (!parse_duration(first.c_str(), out.a)) return false;
+    } else if (name == "normal") {
+        out.dist = Dist::normal;
+        if (!parse_duration(first.c_str(), out.a) || !parse_duration(second.c_str(), out.b)) {
+            return false;
+        }
+    } else if (name == "lognormal") {
+        out.dist = Dist::lognormal;
+        if (!parse_duration(first.c_str(), out.a)) return false;
+        char* end;
+        out.b = strtod(second.c_str(), &end);
+        if (second.empty() || *end != 0 || out.b < 0) return false;
+    } else {
+        return false;
+    }
+    spec = out;
+    return true;
+}
+
+// Draw one duration in nanoseconds.
+template <typename Rng>
+static inline uint64_t sample(const Spec& s, Rng& rng) {
+    double v = 0;
+    switch (s.dist) {
+    case Dist::zero:
+        return 0;
+    case Dist::constant:
+        v = s.a;
+        break;
+    case Dist::uniform:
+        v = std::uniform_real_distribution<double>(s.a, s.b)(rng);
+        break;
+    case Dist::exponential:
+        v = s.a > 0 ? std::exponential_distribution<double>(1.0 / s.a)(rng) : 0;
+        break;
+    case Dist::normal:
+        v = std::normal_distribution<double>(s.a, s.b)(rng);
+        break;
+    case Dist::lognormal: {
+        // choose mu so that the mean is s.a
+        double mu = std::log(s.a > 0 ? s.a : 1) - s.b * s.b / 2;
+        v = std::lognormal_distribution<double>(mu, s.b)(rng);
+        break;
+    }
+    }
+    return v > 0 ? (uint64_t)v : 0;
+}
+
+// CPU-bound wait: keeps the core busy like real work would.
+static inline void busy_for(uint64_t ns) {
+    if (ns == 0) return;
+    uint64_t deadline = trace::now_ns() + ns;
+    while (trace::now_ns() < deadline) {
+        asm volatile("" ::: "memory");
+    }
+}
+
+struct Model {
+    Spec think;
+    Spec eat;
+};
+
+static inline Model& model() {
+    static Model m;
+    return m;
+}
+
+static inline void load_spec(const char* var, Spec& spec) {
+    const char* v = getenv(var);
+    if (v && !parse(v, spec)) {
+        fprintf(stderr, "workload: cannot parse %s=%s, using zero\n", var, v);
+    }
+}
+
+// Read $PHILO_THINK / $PHILO_EAT; call once before creating threads.
+static inline void init() {
+    load_spec("PHILO_THINK", model().think);
+    load_spec("PHILO_EAT", model().eat);
+}
+
+static inline std::mt19937_64& rng(int tid) {
+    static thread_local std::mt19937_64 gen(0x5eed0000ull + (uint64_t)tid);
+    return gen;
+}
+
+static inline void think(int tid) {
+    const Spec& s = model().think;
+    if (s.dist != Dist::zero) busy_for(sample(s, rng(tid)));
+}
+
+static inline void eat(int tid) {
+    const Spec& s = model().eat;
+    if (s.dist != Dist::zero) busy_for(sample(s, rng(tid)));
+}
+
+} // namespace workload
+
+#endif // WORKLOAD_HPP
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../program2/trace.hpp"
+
+// Offline decoder for the binary logs written by program2/trace.hpp.
+//
+//   trace_decode <trace.bin> [text|chrome] [output]
+//
+// "text" prints one event per line; "chrome" writes a JSON file for
+// chrome://tracing / Perfetto where each state is a span that lasts until
+// the next event of the same thread.
+
+static bool load_events(const char* path, std::vector<trace::Event>& events) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    trace::FileHeader hdr;
+    if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) ||
+        memcmp(hdr.magic, trace::MAGIC, sizeof(trace::MAGIC)) != 0) {
+        fprintf(stderr, "%s is not a philosopher trace\n", path);
+        return false;
+    }
+    if (hdr.version != trace::VERSION || hdr.event_size != sizeof(trace::Event)) {
+        fprintf(stderr, "Unsupported trace version %u (event size %u)\n",
+                hdr.version, hdr.event_size);
+        return false;
+    }
+
+    trace::Event e;
+    while (in.read(reinterpret_cast<char*>(&e), sizeof(e))) {
+        events.push_back(e);
+    }
+
+    // rings are drained one thread at a time, so restore global order
+    std::stable_sort(events.begin(), events.end(),
+                     [](const trace::Event& a, const trace::Event& b) {
+                         return a.ts_ns < b.ts_ns;
+                     });
+    return true;
+}
+
+static void write_text(const std::vector<trace::Event>& events, FILE* out) {
+    uint64_t base = events.empty() ? 0 : events.front().ts_ns;
+    for (const auto& e : events) {
+        fprintf(out, "%14.3f us  thread %u  %s\n",
+                (e.ts_ns - base) / 1e3, e.tid, trace::state_name(e.state));
+    }
+}
+
+static void write_chrome(const std::vector<trace::Event>& events, FILE* out) {
+    uint64_t base = events.empty() ? 0 : events.front().ts_ns;
+
+    // index of the next event for the same thread
+    std::vector<size_t> next(events.size(), SIZE_MAX);
+    std::vector<size_t> last_of_tid;
+    for (size_t i = events.size(); i-- > 0;) {
+        uint32_t tid = events[i].tid;
+        if (tid >= last_of_tid.size()) last_of_tid.resize(tid + 1, SIZE_MAX);
+        next[i] = last_of_tid[tid];
+        last_of_tid[tid] = i;
+    }
+
+    fprintf(out, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t i = 0; i < events.size(); ++i) {
+        const auto& e = events[i];
+        double ts = (e.ts_ns - base) / 1e3;
+        if (!first) fprintf(out, ",\n");
+        first = false;
+
+        if (next[i] == SIZE_MAX || e.state == trace::DEADLOCK || e.state == trace::STARVING) {
+            fprintf(out, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                    trace::state_name(e.state), ts, e.tid);
+        } else {
+            double dur = (events[next[i]].ts_ns - e.ts_ns) / 1e3;
+            fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+                    trace::state_name(e.state), ts, dur, e.tid);
+        }
+    }
+    fprintf(out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace.bin> [text|chrome] [output]\n", argv[0]);
+        return 1;
+    }
+    std::string format = argc >= 3 ? argv[2] : "text";
+    if (format != "text" && format != "chrome") {
+        fprintf(stderr, "Unknown format '%s' (expected text or chrome)\n", format.c_str());
+        return 1;
+    }
+
+    std::vector<trace::Event> events;
+    if (!load_events(argv[1], events)) return 1;
+
+    FILE* out = stdout;
+    if (argc >= 4) {
+        out = fopen(argv[3], "w");
+        if (!out) {
+            fprintf(stderr, "Cannot open %s for writing\n", argv[3]);
+            return 1;
+        }
+    }
+
+    if (format == "text") {
+        write_text(events, out);
+    } else {
+        write_chrome(events, out);
+    }
+
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <numeric>
+#include <cstdint>
+
+#include "noblocking_queue.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Same workload as the mixed benchmark, but every operation moves `batch`
+// items through add_bulk/remove_bulk, so the contended head/tail CAS is
+// paid once per batch instead of once per item.
+
+const std::vector<size_t> BATCH_SIZES{1, 4, 16, 64, 256};
+const std::vector<int> BATCH_THREAD_COUNTS{1, 2, 4, 8, 16, 32};
+
+static double run_benchmark_batch(size_t threads, double ratio, size_t batch) {
+    // balanced in whole batches: the prefill is counted in batches too
+    const WorkloadConfig &cfg = workload_config();
+    Workload w = make_workload(threads, TOTAL_OPERATIONS / batch, ratio, workload_prefill(ratio) / batch,
+                               QUEUE_CAPACITY / batch, cfg.kind, cfg.seed);
+
+    NonBlockingQueue<int> queue(QUEUE_CAPACITY);
+    shuffle_queue(queue, w.prefill * batch);
+
+    return run_workers(threads, [&](size_t tid) {
+        const std::vector<uint8_t> &ops = w.ops[tid];
+        std::vector<int> values(batch);
+        std::iota(values.begin(), values.end(), static_cast<int>(tid * 100000));
+        std::vector<int> out(batch);
+
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (ops[i] == 1) {
+                queue.add_bulk(values.data(), batch);
+            } else {
+                // take a full batch, possibly in several pieces
+                size_t got = 0;
+                while (got < batch) {
+                    got += queue.remove_bulk(out.data() + got, batch - got);
+                }
+            }
+        }
+    });
+}
+
+int run_batch_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,threads,ratio,batch,seconds\n";
+
+    for (auto ratio : workload_ratios()) {
+        std::cout << "Benchmarking batches with ratio=" << ratio << " ... \n";
+        for (int threads : BATCH_THREAD_COUNTS) {
+            std::cout << "Running with threads=" << threads << " ... " << std::flush;
+            for (size_t batch : BATCH_SIZES) {
+                double t = run_benchmark_batch(threads, ratio, batch);
+                ofs << "NONBLOCKING_QUEUE," << threads << "," << ratio << "," << batch << ","
+                    << std::fixed << std::setprecision(6) << t << "\n";
+                ofs.flush();
+                std::cout << "batch" << batch << "=" << t << "s ";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
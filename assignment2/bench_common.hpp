@@ -0,0 +1,167 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+#include "bench_runner.hpp"
+#include "workload.hpp"
+
+const size_t TOTAL_OPERATIONS = 1<< 20;
+const size_t QUEUE_CAPACITY = 1 << 20; // 队列容量
+const std::vector<double> RATIO{0.3, 0.5, 0.8}; // 不同入队出队比例
+const std::vector<int> THREAD_COUNTS = [](){
+    std::vector<int> v;
+    for (int i = 1; i <= 32; ++i) v.push_back(i);
+    return v;
+}();
+
+template<typename QueueType>
+static inline void shuffle_queue(QueueType &queue, size_t eqn_count) {
+    while (eqn_count > 0) {
+        int random_ = rand() % 1000000;
+        queue.add(random_);
+        --eqn_count;
+    }
+}
+
+static inline size_t prefill_items(double ratio) {
+    if (ratio == 0.3)
+        return TOTAL_OPERATIONS * 0.5;
+    else if (ratio == 0.5)
+        return TOTAL_OPERATIONS * 0.3;
+    else
+        return TOTAL_OPERATIONS * 0.1;
+}
+
+// 预填充 避免空队列卡死
+template<typename QueueType>
+static inline void prefill_queue(QueueType &queue, double ratio) {
+    shuffle_queue(queue, prefill_items(ratio));
+}
+
+// Prefill for the workload selected with --workload: prefill_items(ratio),
+// or none for patterned, whose own adds always cover its removes.
+static inline size_t workload_prefill(double ratio) {
+    return workload_config().kind == workload_kind::patterned ? 0 : prefill_items(ratio);
+}
+
+// The mixed workload for one point: TOTAL_OPERATIONS ops over `threads`
+// threads after workload_prefill(ratio), of the kind and seed selected
+// with --workload and --seed, sized for a QUEUE_CAPACITY queue.
+static inline Workload mixed_workload(size_t threads, double ratio) {
+    const WorkloadConfig &cfg = workload_config();
+    return make_workload(threads, TOTAL_OPERATIONS, ratio, workload_prefill(ratio), QUEUE_CAPACITY, cfg.kind,
+                         cfg.seed);
+}
+
+// The ratios a mode sweeps: RATIO, or only PATTERNED_RATIO for the
+// patterned workload, whose mix is fixed.
+static inline std::vector<double> workload_ratios() {
+    if (workload_config().kind == workload_kind::patterned) return {PATTERNED_RATIO};
+    return RATIO;
+}
+
+// Run fn(tid) on `threads` threads, pinned per runner_config().pin, all
+// released at once after every thread has checked in; returns the seconds
+// from the release until the last thread has finished.
+template<typename Fn>
+static inline double run_workers(size_t threads, Fn fn) {
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> start_flag{false};
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            pin_current_thread(t);
+            ready.fetch_add(1, std::memory_order_release);
+            while (!start_flag.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            fn(t);
+        });
+    }
+    while (ready.load(std::memory_order_acquire) != threads) {
+        std::this_thread::yield();
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    start_flag.store(true, std::memory_order_release);
+    for (auto &th : workers) th.join();
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - t0;
+    return dur.count();
+}
+
+// Split total into parts shares that differ by at most one.
+static inline std::vector<size_t> split_evenly(size_t total, size_t parts) {
+    std::vector<size_t> v(parts, total / parts);
+    for (size_t i = 0; i < total % parts; ++i) ++v[i];
+    return v;
+}
+
+// Wait until `deadline`: sleep while it is far off, then spin.
+static inline void pace_until(std::chrono::steady_clock::time_point deadline) {
+    auto now = std::chrono::steady_clock::now();
+    if (deadline - now > std::chrono::microseconds(100)) {
+        std::this_thread::sleep_until(deadline - std::chrono::microseconds(50));
+    }
+    while (std::chrono::steady_clock::now() < deadline) {}
+}
+
+// How the producer/consumer runs make the i-th item of a queue's
+// value_type; specialised for the payload types in bench_payload.cpp.
+template<typename V>
+struct item_traits {
+    static V make(size_t i) { return static_cast<V>(i); }
+};
+
+// `producers` threads add `items` values between them, paced to `rate`
+// items/s in total (0 = as fast as possible); `consumers` threads each
+// remove a fixed share. The run ends when every item has been consumed, so
+// no prefill is needed. Returns the seconds from the release until the
+// last consumer took its last item.
+template<typename QueueType>
+static inline double run_producers_consumers(QueueType &queue, size_t producers, size_t consumers,
+                                             size_t items, double rate = 0) {
+    typedef typename QueueType::value_type V;
+    std::vector<size_t> produce = split_evenly(items, producers);
+    std::vector<size_t> consume = split_evenly(items, consumers);
+    std::vector<std::chrono::steady_clock::time_point> finished(consumers);
+    std::chrono::steady_clock::time_point t0;
+
+    run_workers(producers + consumers, [&](size_t tid) {
+        if (tid == 0) t0 = std::chrono::steady_clock::now();
+        if (tid < producers) {
+            size_t base = tid * 100000;
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::duration<double> gap(rate > 0 ? producers / rate : 0);
+            for (size_t i = 0; i < produce[tid]; ++i) {
+                if (rate > 0) {
+                    pace_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(gap * (double)i));
+                }
+                queue.add(item_traits<V>::make(base + i));
+            }
+        } else {
+            size_t c = tid - producers;
+            for (size_t i = 0; i < consume[c]; ++i) {
+                V val = queue.remove();
+                (void)val;
+            }
+            finished[c] = std::chrono::steady_clock::now();
+        }
+    });
+
+    auto last = *std::max_element(finished.begin(), finished.end());
+    std::chrono::duration<double> dur = last - t0;
+    return dur.count();
+}
+
+#endif // BENCH_COMMON_HPP
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <iomanip>
+#include <sys/resource.h>
+
+#include "noblocking_queue.hpp"
+#include "tbb_queue.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Consumers block on an empty queue while nothing is produced. Measures
+// the CPU time they burn doing so, and how long it takes to wake them all
+// once one item per consumer is finally added.
+
+const std::vector<int> IDLE_CONSUMERS{1, 2, 4, 8, 16, 32};
+const double IDLE_SECONDS = 0.2;
+
+static double cpu_seconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+struct IdleResult {
+    double cpu_per_consumer;   // CPU seconds per consumer per idle second
+    double wake_seconds;       // from the first add until every consumer returned
+};
+
+template<typename QueueType>
+static IdleResult run_idle(int consumers) {
+    QueueType queue(QUEUE_CAPACITY);
+    std::vector<std::thread> workers;
+    for (int c = 0; c < consumers; ++c) {
+        workers.emplace_back([&]() { (void)queue.remove(); });
+    }
+    // let them reach their idle state before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    double cpu0 = cpu_seconds();
+    auto t0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(IDLE_SECONDS));
+    double cpu1 = cpu_seconds();
+    auto t1 = std::chrono::steady_clock::now();
+
+    for (int c = 0; c < consumers; ++c) queue.add(c);
+    for (auto &th : workers) th.join();
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> idle = t1 - t0, wake = t2 - t1;
+    return {(cpu1 - cpu0) / idle.count() / consumers, wake.count()};
+}
+
+template<typename QueueType>
+static void report_idle(std::ofstream &ofs, const char *name, const char *wait, int consumers) {
+    IdleResult r = run_idle<QueueType>(consumers);
+    ofs << name << "," << wait << "," << consumers << "," << std::fixed << std::setprecision(6)
+        << r.cpu_per_consumer << "," << r.wake_seconds << "\n";
+    ofs.flush();
+    std::cout << name << "/" << wait << "=" << r.cpu_per_consumer << "cpu " << std::flush;
+}
+
+int run_idle_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,wait,consumers,cpu_per_consumer,wake_seconds\n";
+
+    for (int consumers : IDLE_CONSUMERS) {
+        std::cout << "Running with consumers=" << consumers << " ... " << std::flush;
+        report_idle<NonBlockingQueue<int>>(ofs, "NONBLOCKING_QUEUE", spin_wait::name, consumers);
+        report_idle<NonBlockingQueue<int, nbq_layout<>, eventcount_wait>>(ofs, "NONBLOCKING_QUEUE",
+                                                                          eventcount_wait::name, consumers);
+        report_idle<TBBQueue<int>>(ofs, "TBB_QUEUE", spin_wait::name, consumers);
+        report_idle<TBBQueue<int, eventcount_wait>>(ofs, "TBB_QUEUE", eventcount_wait::name, consumers);
+        std::cout << "\n";
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
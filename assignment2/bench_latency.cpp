@@ -0,0 +1,115 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <cstdint>
+
+#include "blocking_queue.hpp"
+#include "noblocking_queue.hpp"
+#include "tbb_queue.hpp"
+#include "ms_queue.hpp"
+#include "faa_queue.hpp"
+#include "latency_histogram.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// The mixed workload again, but every add/remove is timed with
+// steady_clock into a per-thread histogram. Items are their own enqueue
+// timestamp, so the remover also records how long each one sat in the
+// queue (sojourn). Prefilled items carry 0 and are left out of sojourn.
+
+const std::vector<int> LATENCY_THREAD_COUNTS{1, 2, 4, 8, 16, 32};
+
+struct alignas(64) ThreadLatency {
+    LatencyHistogram add_ns;
+    LatencyHistogram remove_ns;
+    LatencyHistogram sojourn_ns;
+};
+
+struct LatencyResult {
+    double seconds;
+    LatencyHistogram add_ns;
+    LatencyHistogram remove_ns;
+    LatencyHistogram sojourn_ns;
+};
+
+template<typename QueueType>
+static LatencyResult run_latency(size_t threads, double ratio) {
+    QueueType queue(QUEUE_CAPACITY);
+    Workload w = mixed_workload(threads, ratio);
+    for (size_t i = 0; i < w.prefill; ++i) queue.add(0);
+
+    std::vector<ThreadLatency> lat(threads);
+
+    LatencyResult r;
+    r.seconds = run_workers(threads, [&](size_t tid) {
+        ThreadLatency &l = lat[tid];
+        const std::vector<uint8_t> &ops = w.ops[tid];
+        for (size_t i = 0; i < ops.size(); ++i) {
+            uint64_t t0 = now_ns();
+            if (ops[i] == 1) {
+                queue.add(t0);
+                l.add_ns.record(now_ns() - t0);
+            } else {
+                uint64_t stamp = queue.remove();
+                uint64_t t1 = now_ns();
+                l.remove_ns.record(t1 - t0);
+                if (stamp != 0) l.sojourn_ns.record(t1 - stamp);
+            }
+        }
+    });
+
+    for (const ThreadLatency &l : lat) {
+        r.add_ns.merge(l.add_ns);
+        r.remove_ns.merge(l.remove_ns);
+        r.sojourn_ns.merge(l.sojourn_ns);
+    }
+    return r;
+}
+
+static void write_percentiles(std::ofstream &ofs, const LatencyHistogram &h) {
+    ofs << "," << h.percentile(50) << "," << h.percentile(99) << "," << h.percentile(99.9) << "," << h.maximum();
+}
+
+template<typename QueueType>
+static void report_latency(std::ofstream &ofs, const char *name, int threads, double ratio) {
+    LatencyResult r = run_latency<QueueType>(threads, ratio);
+    ofs << name << "," << threads << "," << ratio << "," << std::fixed << std::setprecision(6) << r.seconds
+        << std::defaultfloat;
+    write_percentiles(ofs, r.add_ns);
+    write_percentiles(ofs, r.remove_ns);
+    write_percentiles(ofs, r.sojourn_ns);
+    ofs << "\n";
+    ofs.flush();
+    std::cout << name << "=" << r.remove_ns.percentile(99) << "ns " << std::flush;
+}
+
+int run_latency_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,threads,ratio,seconds";
+    for (const char *op : {"add", "remove", "sojourn"}) {
+        ofs << "," << op << "_p50_ns," << op << "_p99_ns," << op << "_p999_ns," << op << "_max_ns";
+    }
+    ofs << "\n";
+
+    for (auto ratio : workload_ratios()) {
+        std::cout << "Benchmarking latency with ratio=" << ratio << " (remove p99) ... \n";
+        for (int threads : LATENCY_THREAD_COUNTS) {
+            std::cout << "Running with threads=" << threads << " ... " << std::flush;
+            report_latency<BlockingQueue<uint64_t>>(ofs, "BLOCKING_QUEUE", threads, ratio);
+            report_latency<NonBlockingQueue<uint64_t>>(ofs, "NONBLOCKING_QUEUE", threads, ratio);
+            report_latency<TBBQueue<uint64_t>>(ofs, "TBB_QUEUE", threads, ratio);
+            report_latency<MSQueue<uint64_t>>(ofs, "MS_QUEUE", threads, ratio);
+            report_latency<FAAQueue<uint64_t>>(ofs, "FAA_QUEUE", threads, ratio);
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef BENCH_MODES_HPP
+#define BENCH_MODES_HPP
+
+#pragma once
+
+#include <string>
+
+// Benchmark modes besides the default mixed enqueue/dequeue run.
+// Each writes its own CSV and returns the process exit code.
+
+// NonBlockingQueue add_bulk/remove_bulk with a sweep over batch sizes
+int run_batch_mode(const std::string &out_csv);
+
+// CPU burnt by consumers blocked on an empty queue, spin vs eventcount
+int run_idle_mode(const std::string &out_csv);
+
+// dedicated producer/consumer threads on the SPSC/MPSC/SPMC/MPMC rings
+int run_role_mode(const std::string &out_csv);
+
+// P producers : C consumers on the MPMC queues, optionally rate limited
+int run_pc_mode(const std::string &out_csv);
+
+// per-operation add/remove latency and sojourn time percentiles
+int run_latency_mode(const std::string &out_csv);
+
+// struct payloads of 16..1024 bytes and a move-only unique_ptr
+int run_payload_mode(const std::string &out_csv);
+
+// try_add/try_remove on a small queue without prefill, failures counted
+int run_try_mode(const std::string &out_csv);
+
+// try_add_for/try_remove_for that time out: lateness and CPU per waiter
+int run_timeout_mode(const std::string &out_csv);
+
+// fork/join task throughput: work-stealing pool vs one shared queue
+int run_pool_mode(const std::string &out_csv);
+
+// MultiQueue vs a locked std::priority_queue: throughput and rank error
+int run_pq_mode(const std::string &out_csv);
+
+// producer and consumer in two processes: ShmQueue vs a Unix socket
+int run_shm_mode(const std::string &out_csv);
+
+// ring storage policies: first-touch vs reused rings
+int run_storage_mode(const std::string &out_csv);
+
+#endif // BENCH_MODES_HPP
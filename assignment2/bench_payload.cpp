@@ -0,0 +1,85 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <memory>
+#include <cstring>
+
+#include "blocking_queue.hpp"
+#include "noblocking_queue.hpp"
+#include "tbb_queue.hpp"
+#include "ms_queue.hpp"
+#include "faa_queue.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Producer/consumer runs with items bigger than an int: fixed-size message
+// structs with no default constructor, and a move-only unique_ptr to one.
+// Capacity and item count are smaller than in the other modes so a 1 KiB
+// payload still fits comfortably in memory.
+
+const size_t PAYLOAD_CAPACITY = 1 << 14;
+const size_t PAYLOAD_ITEMS = 1 << 18;
+const std::vector<std::pair<int, int>> PAYLOAD_SPLITS{{1, 1}, {4, 4}};
+
+template<size_t N>
+struct Payload {
+    explicit Payload(size_t seed) { memset(bytes, (int)(seed & 0xff), N); }
+    unsigned char bytes[N];
+};
+
+template<size_t N>
+struct item_traits<Payload<N>> {
+    static Payload<N> make(size_t i) { return Payload<N>(i); }
+};
+
+template<typename P>
+struct item_traits<std::unique_ptr<P>> {
+    static std::unique_ptr<P> make(size_t i) { return std::make_unique<P>(i); }
+};
+
+template<typename QueueType>
+static void report_payload(std::ofstream &ofs, const char *name, const char *payload, size_t bytes,
+                           int producers, int consumers) {
+    QueueType queue(PAYLOAD_CAPACITY);
+    double t = run_producers_consumers(queue, producers, consumers, PAYLOAD_ITEMS);
+    ofs << name << "," << payload << "," << bytes << "," << producers << "," << consumers << "," << std::fixed
+        << std::setprecision(6) << t << "," << std::setprecision(0) << PAYLOAD_ITEMS / t << ","
+        << std::setprecision(1) << PAYLOAD_ITEMS * bytes / t / 1e6 << "\n";
+    ofs.flush();
+    std::cout << name << "=" << std::setprecision(6) << t << "s " << std::flush;
+}
+
+template<typename V>
+static void report_all_queues(std::ofstream &ofs, const char *payload, size_t bytes) {
+    for (const auto &pc : PAYLOAD_SPLITS) {
+        std::cout << "Running " << payload << " " << pc.first << ":" << pc.second << " ... " << std::flush;
+        report_payload<BlockingQueue<V>>(ofs, "BLOCKING_QUEUE", payload, bytes, pc.first, pc.second);
+        report_payload<NonBlockingQueue<V>>(ofs, "NONBLOCKING_QUEUE", payload, bytes, pc.first, pc.second);
+        report_payload<TBBQueue<V>>(ofs, "TBB_QUEUE", payload, bytes, pc.first, pc.second);
+        report_payload<MSQueue<V>>(ofs, "MS_QUEUE", payload, bytes, pc.first, pc.second);
+        report_payload<FAAQueue<V>>(ofs, "FAA_QUEUE", payload, bytes, pc.first, pc.second);
+        std::cout << "\n";
+    }
+}
+
+int run_payload_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,payload,bytes,producers,consumers,seconds,items_per_sec,mb_per_sec\n";
+
+    report_all_queues<int>(ofs, "int", sizeof(int));
+    report_all_queues<Payload<16>>(ofs, "struct16", 16);
+    report_all_queues<Payload<64>>(ofs, "struct64", 64);
+    report_all_queues<Payload<256>>(ofs, "struct256", 256);
+    report_all_queues<Payload<1024>>(ofs, "struct1024", 1024);
+    // move-only: the queue carries the pointer, bytes counts the pointee
+    report_all_queues<std::unique_ptr<Payload<256>>>(ofs, "unique_ptr256", 256);
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
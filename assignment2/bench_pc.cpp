@@ -0,0 +1,61 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <utility>
+
+#include "blocking_queue.hpp"
+#include "noblocking_queue.hpp"
+#include "tbb_queue.hpp"
+#include "ms_queue.hpp"
+#include "faa_queue.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// P producers and C consumers on every MPMC queue, with and without a
+// limit on the producers' total rate. Throughput is items consumed over
+// the time until the last consumer finished; the run ends on item count,
+// so nothing is prefilled.
+
+const std::vector<std::pair<int, int>> PC_SPLITS{
+    {1, 1}, {2, 2}, {4, 4}, {8, 8}, {16, 16},
+    {1, 4}, {1, 16}, {4, 1}, {16, 1},
+};
+// total items per second over all producers, 0 = unlimited
+const std::vector<double> PC_RATES{0, 20e6, 5e6};
+
+template<typename QueueType>
+static void report_pc(std::ofstream &ofs, const char *name, int producers, int consumers, double rate) {
+    QueueType queue(QUEUE_CAPACITY);
+    double t = run_producers_consumers(queue, producers, consumers, TOTAL_OPERATIONS, rate);
+    ofs << name << "," << producers << "," << consumers << "," << std::fixed << std::setprecision(0) << rate
+        << "," << std::setprecision(6) << t << "," << std::setprecision(0) << TOTAL_OPERATIONS / t << "\n";
+    ofs.flush();
+    std::cout << name << "=" << std::setprecision(6) << t << "s " << std::flush;
+}
+
+int run_pc_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,producers,consumers,rate,seconds,items_per_sec\n";
+
+    for (double rate : PC_RATES) {
+        std::cout << "Benchmarking with rate=" << (rate > 0 ? std::to_string((long)rate) : "unlimited") << " ... \n";
+        for (const auto &pc : PC_SPLITS) {
+            std::cout << "Running " << pc.first << ":" << pc.second << " ... " << std::flush;
+            report_pc<BlockingQueue<int>>(ofs, "BLOCKING_QUEUE", pc.first, pc.second, rate);
+            report_pc<NonBlockingQueue<int>>(ofs, "NONBLOCKING_QUEUE", pc.first, pc.second, rate);
+            report_pc<TBBQueue<int>>(ofs, "TBB_QUEUE", pc.first, pc.second, rate);
+            report_pc<MSQueue<int>>(ofs, "MS_QUEUE", pc.first, pc.second, rate);
+            report_pc<FAAQueue<int>>(ofs, "FAA_QUEUE", pc.first, pc.second, rate);
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+
+#include "blocking_queue.hpp"
+#include "noblocking_queue.hpp"
+#include "tbb_queue.hpp"
+#include "ms_queue.hpp"
+#include "faa_queue.hpp"
+#include "task_pool.hpp"
+#include "bench_runner.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Task throughput of the work-stealing pool against pools that push every
+// task through one shared queue.
+//
+// fib:          recursive fork/join, serial below FIB_CUTOFF
+// parallel_for: binary splitting of PFOR_N indices down to PFOR_GRAIN
+
+const std::vector<int> POOL_THREAD_COUNTS{1, 2, 4, 8, 16, 32};
+const int FIB_N = 30;
+const int FIB_CUTOFF = 12;
+const size_t PFOR_N = 1 << 22;
+const size_t PFOR_GRAIN = 1024;
+
+static uint64_t fib_serial(int n) {
+    return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+// tasks spawned by fib_task(n)
+static uint64_t fib_tasks(int n) {
+    return n < FIB_CUTOFF ? 0 : 1 + fib_tasks(n - 1) + fib_tasks(n - 2);
+}
+
+template<typename Pool>
+static void fib_task(Pool &pool, int n, uint64_t *out) {
+    if (n < FIB_CUTOFF) {
+        *out = fib_serial(n);
+        return;
+    }
+    uint64_t a, b;
+    TaskGroup g;
+    pool.spawn(g, [&pool, n, &a]() { fib_task(pool, n - 1, &a); });
+    fib_task(pool, n - 2, &b);
+    pool.wait(g);
+    *out = a + b;
+}
+
+static inline uint64_t mix(uint64_t x) {
+    x *= 0x9E3779B97F4A7C15ull;
+    return x ^ (x >> 29);
+}
+
+template<typename Pool>
+static void parallel_sum(Pool &pool, size_t lo, size_t hi, std::atomic<uint64_t> *total) {
+    TaskGroup g;
+    while (hi - lo > PFOR_GRAIN) {
+        size_t mid = lo + (hi - lo) / 2;
+        pool.spawn(g, [&pool, mid, hi, total]() { parallel_sum(pool, mid, hi, total); });
+        hi = mid;
+    }
+    uint64_t sum = 0;
+    for (size_t i = lo; i < hi; ++i) sum += mix(i);
+    total->fetch_add(sum, std::memory_order_relaxed);
+    pool.wait(g);
+}
+
+static uint64_t pfor_tasks() {
+    return PFOR_N / PFOR_GRAIN - 1;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+    return d.count();
+}
+
+static void write_point(std::ofstream &ofs, const char *name, int threads, const char *workload,
+                        uint64_t tasks, const Summary &s) {
+    ofs << name << "," << threads << "," << workload << "," << tasks << "," << std::fixed << std::setprecision(6)
+        << s.median << "," << s.ci_low << "," << s.ci_high << "," << s.n << "," << std::setprecision(0)
+        << tasks / s.median << "\n";
+    ofs.flush();
+}
+
+template<typename Pool>
+static bool report_pool(std::ofstream &ofs, const char *name, int threads) {
+    Pool pool(threads, 1 << 16, [](size_t i) { pin_current_thread(i); });
+    pin_current_thread(0);
+
+    const uint64_t fib_expected = fib_serial(FIB_N);
+    bool ok = true;
+    Summary fib = measure([&]() {
+        uint64_t r = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        fib_task(pool, FIB_N, &r);
+        double t = seconds_since(t0);
+        ok = ok && r == fib_expected;
+        return t;
+    });
+    write_point(ofs, name, threads, "fib", fib_tasks(FIB_N), fib);
+
+    uint64_t pfor_expected = 0;
+    for (size_t i = 0; i < PFOR_N; ++i) pfor_expected += mix(i);
+    Summary pfor = measure([&]() {
+        std::atomic<uint64_t> total{0};
+        auto t0 = std::chrono::steady_clock::now();
+        parallel_sum(pool, 0, PFOR_N, &total);
+        double t = seconds_since(t0);
+        ok = ok && total.load() == pfor_expected;
+        return t;
+    });
+    write_point(ofs, name, threads, "parallel_for", pfor_tasks(), pfor);
+
+    std::cout << name << "=" << std::setprecision(6) << fib.median << "s/" << pfor.median << "s " << std::flush;
+    if (!ok) std::cerr << "\n" << name << ": wrong result with " << threads << " threads\n";
+    return ok;
+}
+
+int run_pool_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "pool,threads,workload,tasks,seconds,seconds_ci_low,seconds_ci_high,repetitions,tasks_per_sec\n";
+
+    bool ok = true;
+    for (int threads : POOL_THREAD_COUNTS) {
+        std::cout << "Running with threads=" << threads << " ... " << std::flush;
+        ok &= report_pool<TaskPool<NonBlockingQueue<pool_task *>, true>>(ofs, "WORK_STEALING", threads);
+        ok &= report_pool<TaskPool<BlockingQueue<pool_task *>, false>>(ofs, "BLOCKING_QUEUE", threads);
+        ok &= report_pool<TaskPool<NonBlockingQueue<pool_task *>, false>>(ofs, "NONBLOCKING_QUEUE", threads);
+        ok &= report_pool<TaskPool<TBBQueue<pool_task *>, false>>(ofs, "TBB_QUEUE", threads);
+        ok &= report_pool<TaskPool<MSQueue<pool_task *>, false>>(ofs, "MS_QUEUE", threads);
+        ok &= report_pool<TaskPool<FAAQueue<pool_task *>, false>>(ofs, "FAA_QUEUE", threads);
+        std::cout << "\n";
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return ok ? 0 : 1;
+}
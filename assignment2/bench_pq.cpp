@@ -0,0 +1,156 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#include "multi_queue.hpp"
+#include "random_bits.hpp"
+#include "latency_histogram.hpp"
+#include "bench_runner.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// MultiQueue against one locked std::priority_queue.
+//
+// After PQ_PREFILL random keys, every thread alternates add(random key)
+// and try_remove over TOTAL_OPERATIONS operations in all, so the size
+// stays about constant. Throughput is timed with measure(). A separate,
+// untimed run stamps each operation from a shared counter (before an add,
+// after a remove) and replays them in stamp order on an exact counter of
+// keys: the rank of a removed key is how many smaller keys were in the
+// queue at that point.
+
+const std::vector<int> PQ_THREAD_COUNTS{1, 2, 4, 8, 16, 32};
+const size_t PQ_PREFILL = 1 << 16;
+const uint64_t PQ_KEY_SPACE = 1 << 20;
+
+struct PqOp {
+    uint64_t stamp;
+    uint64_t key;
+    bool remove;
+};
+
+template<typename Q>
+static void pq_prefill(Q &q) {
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < PQ_PREFILL; ++i) {
+        uint64_t k = xorshift64(rng) % PQ_KEY_SPACE;
+        q.add(k, k);
+    }
+}
+
+// Stamped ops of all threads; `Stamp` decides whether to record.
+template<typename Q, bool Stamp>
+static double pq_run(Q &q, size_t threads, std::vector<std::vector<PqOp>> *logs, std::atomic<uint64_t> *clock) {
+    size_t ops_per_thread = TOTAL_OPERATIONS / threads;
+    return run_workers(threads, [&](size_t tid) {
+        uint64_t rng = 0x9E3779B97F4A7C15ull * (tid + 1);
+        for (size_t i = 0; i < ops_per_thread; ++i) {
+            uint64_t k, v;
+            if (i % 2 == 0) {
+                k = xorshift64(rng) % PQ_KEY_SPACE;
+                if (Stamp) (*logs)[tid].push_back(PqOp{clock->fetch_add(1), k, false});
+                q.add(k, k);
+            } else if (q.try_remove(k, v)) {
+                if (Stamp) (*logs)[tid].push_back(PqOp{clock->fetch_add(1), k, true});
+            }
+        }
+    });
+}
+
+// Fenwick tree of key counts
+class KeyCounter {
+    std::vector<uint32_t> tree;
+
+public:
+    explicit KeyCounter(size_t n) : tree(n + 1, 0) {}
+
+    void add(uint64_t key, int d) {
+        for (size_t i = key + 1; i < tree.size(); i += i & -i) tree[i] += d;
+    }
+
+    // keys < key
+    uint64_t below(uint64_t key) const {
+        uint64_t s = 0;
+        for (size_t i = key; i > 0; i -= i & -i) s += tree[i];
+        return s;
+    }
+};
+
+struct RankError {
+    double mean = 0;
+    LatencyHistogram hist;   // the histogram works for any counts, not only ns
+};
+
+template<typename Q, typename... Args>
+static RankError pq_rank_error(size_t threads, Args... args) {
+    Q q(args...);
+    pq_prefill(q);
+    std::vector<std::vector<PqOp>> logs(threads);
+    for (auto &l : logs) l.reserve(TOTAL_OPERATIONS / threads);
+    std::atomic<uint64_t> clock{0};
+    pq_run<Q, true>(q, threads, &logs, &clock);
+
+    std::vector<PqOp> all;
+    for (const auto &l : logs) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end(), [](const PqOp &a, const PqOp &b) { return a.stamp < b.stamp; });
+
+    KeyCounter present(PQ_KEY_SPACE);
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < PQ_PREFILL; ++i) present.add(xorshift64(rng) % PQ_KEY_SPACE, 1);
+
+    RankError r;
+    double sum = 0;
+    for (const PqOp &op : all) {
+        if (!op.remove) {
+            present.add(op.key, 1);
+        } else {
+            uint64_t rank = present.below(op.key);
+            r.hist.record(rank);
+            sum += rank;
+            present.add(op.key, -1);
+        }
+    }
+    if (r.hist.count()) r.mean = sum / r.hist.count();
+    return r;
+}
+
+template<typename Q, typename... Args>
+static void report_pq(std::ofstream &ofs, const char *name, int threads, Args... args) {
+    Summary s = measure([&]() {
+        Q q(args...);
+        pq_prefill(q);
+        return pq_run<Q, false>(q, threads, nullptr, nullptr);
+    });
+    RankError rank = pq_rank_error<Q>(threads, args...);
+
+    ofs << name << "," << threads << "," << std::fixed << std::setprecision(6) << s.median << "," << s.ci_low << ","
+        << s.ci_high << "," << s.n << "," << std::setprecision(0) << TOTAL_OPERATIONS / s.median << ","
+        << std::setprecision(2) << rank.mean << "," << rank.hist.percentile(99) << "," << rank.hist.maximum() << "\n";
+    ofs.flush();
+    std::cout << name << "=" << std::setprecision(6) << s.median << "s " << std::flush;
+}
+
+int run_pq_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,threads,seconds,seconds_ci_low,seconds_ci_high,repetitions,ops_per_sec,rank_mean,rank_p99,rank_max\n";
+
+    for (int threads : PQ_THREAD_COUNTS) {
+        std::cout << "Running with threads=" << threads << " ... " << std::flush;
+        report_pq<LockedPriorityQueue<uint64_t>>(ofs, "LOCKED_PQ", threads, (size_t)threads);
+        report_pq<MultiQueue<uint64_t>>(ofs, "MULTIQUEUE_C2", threads, (size_t)threads, (size_t)2);
+        report_pq<MultiQueue<uint64_t>>(ofs, "MULTIQUEUE_C4", threads, (size_t)threads, (size_t)4);
+        std::cout << "\n";
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
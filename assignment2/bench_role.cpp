@@ -0,0 +1,55 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <utility>
+#include <cstdint>
+
+#include "role_queue.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Dedicated producer and consumer threads (run_producers_consumers) on
+// the specialised ring each shape allows and on the MPMC ring.
+
+const std::vector<int> ROLE_SIDES{2, 4, 8, 16};
+
+template<role R>
+static void report_roles(std::ofstream &ofs, size_t producers, size_t consumers) {
+    RoleQueue<int, R> queue(QUEUE_CAPACITY);
+    double t = run_producers_consumers(queue, producers, consumers, TOTAL_OPERATIONS);
+    ofs << role_name(R) << "," << producers << "," << consumers << "," << std::fixed << std::setprecision(6)
+        << t << "," << std::setprecision(0) << TOTAL_OPERATIONS / t << "\n";
+    ofs.flush();
+    std::cout << role_name(R) << "=" << std::setprecision(6) << t << "s " << std::flush;
+}
+
+int run_role_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,producers,consumers,seconds,items_per_sec\n";
+
+    std::cout << "Running 1:1 ... " << std::flush;
+    report_roles<role::spsc>(ofs, 1, 1);
+    report_roles<role::mpsc>(ofs, 1, 1);
+    report_roles<role::spmc>(ofs, 1, 1);
+    report_roles<role::mpmc>(ofs, 1, 1);
+    std::cout << "\n";
+
+    for (int n : ROLE_SIDES) {
+        std::cout << "Running " << n << ":1 ... " << std::flush;
+        report_roles<role::mpsc>(ofs, n, 1);
+        report_roles<role::mpmc>(ofs, n, 1);
+        std::cout << "\nRunning 1:" << n << " ... " << std::flush;
+        report_roles<role::spmc>(ofs, 1, n);
+        report_roles<role::mpmc>(ofs, 1, n);
+        std::cout << "\n";
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,202 @@
+#ifndef BENCH_RUNNER_HPP
+#define BENCH_RUNNER_HPP
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <tuple>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Repetition, thread placement and machine state for the benchmark modes.
+//
+// measure() runs a point `warmup` times untimed and `repetitions` times
+// timed and reports the median with a distribution-free 95% confidence
+// interval (order statistics of the binomial, so no normality assumption).
+// run_workers() places thread t on the t-th CPU of the selected order.
+
+enum class pin_policy { none, compact, scatter };
+
+static inline const char *pin_name(pin_policy p) {
+    switch (p) {
+    case pin_policy::none: return "none";
+    case pin_policy::compact: return "compact";
+    case pin_policy::scatter: return "scatter";
+    }
+    return "?";
+}
+
+static inline bool parse_pin(const std::string &s, pin_policy &out) {
+    if (s == "none") out = pin_policy::none;
+    else if (s == "compact") out = pin_policy::compact;
+    else if (s == "scatter") out = pin_policy::scatter;
+    else return false;
+    return true;
+}
+
+struct RunnerConfig {
+    int warmup = 1;
+    int repetitions = 5;
+    pin_policy pin = pin_policy::none;
+};
+
+// inline, not static: one config shared by main.cpp and every bench_*.cpp
+inline RunnerConfig &runner_config() {
+    static RunnerConfig cfg;
+    return cfg;
+}
+
+static inline int read_sys_int(const std::string &path, int fallback) {
+    std::ifstream in(path);
+    int v;
+    return (in >> v) ? v : fallback;
+}
+
+// CPUs we may run on, ordered for the policy:
+//   compact  fill a core's hyperthreads, then the next core, then the next package
+//   scatter  one thread per core, alternating packages, siblings only after that
+static inline std::vector<int> cpu_order(pin_policy policy) {
+    struct Cpu { int cpu, package, core, sibling, core_rank; };
+    std::vector<Cpu> cpus;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (!CPU_ISSET(c, &set)) continue;
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(c) + "/topology/";
+        cpus.push_back({c, read_sys_int(base + "physical_package_id", 0), read_sys_int(base + "core_id", c), 0, 0});
+    }
+
+    std::sort(cpus.begin(), cpus.end(), [](const Cpu &a, const Cpu &b) {
+        return std::make_tuple(a.package, a.core, a.cpu) < std::make_tuple(b.package, b.core, b.cpu);
+    });
+    std::map<int, int> cores_in_package;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        bool same_core = i > 0 && cpus[i].package == cpus[i - 1].package && cpus[i].core == cpus[i - 1].core;
+        if (same_core) {
+            cpus[i].sibling = cpus[i - 1].sibling + 1;
+            cpus[i].core_rank = cpus[i - 1].core_rank;
+        } else {
+            cpus[i].core_rank = cores_in_package[cpus[i].package]++;
+        }
+    }
+    if (policy == pin_policy::scatter) {
+        std::stable_sort(cpus.begin(), cpus.end(), [](const Cpu &a, const Cpu &b) {
+            return std::make_tuple(a.sibling, a.core_rank, a.package) <
+                   std::make_tuple(b.sibling, b.core_rank, b.package);
+        });
+    }
+
+    std::vector<int> order;
+    for (const Cpu &c : cpus) order.push_back(c.cpu);
+    return order;
+}
+
+static inline void pin_current_thread(size_t tid) {
+    pin_policy policy = runner_config().pin;
+    if (policy == pin_policy::none) return;
+    static const std::vector<int> compact = cpu_order(pin_policy::compact);
+    static const std::vector<int> scatter = cpu_order(pin_policy::scatter);
+    const std::vector<int> &order = policy == pin_policy::compact ? compact : scatter;
+    if (order.empty()) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(order[tid % order.size()], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+struct Summary {
+    double median = 0;
+    double ci_low = 0;     // 95% confidence interval of the median
+    double ci_high = 0;
+    int n = 0;
+};
+
+static inline Summary summarize(std::vector<double> xs) {
+    Summary s;
+    s.n = (int)xs.size();
+    if (xs.empty()) return s;
+    std::sort(xs.begin(), xs.end());
+    size_t n = xs.size();
+    s.median = n % 2 ? xs[n / 2] : (xs[n / 2 - 1] + xs[n / 2]) / 2;
+
+    // largest k with P(Binomial(n, 1/2) < k) <= 2.5%; the interval is
+    // [x_(k), x_(n-k+1)], or the whole range when n is too small for that
+    double p = std::pow(0.5, (double)n), cdf = 0;
+    size_t k = 0;
+    while (k < n && cdf + p <= 0.025) {
+        cdf += p;
+        p = p * (double)(n - k) / (double)(k + 1);
+        ++k;
+    }
+    if (k == 0) k = 1;
+    s.ci_low = xs[k - 1];
+    s.ci_high = xs[n - k];
+    return s;
+}
+
+template<typename Fn>
+static inline Summary measure(Fn fn) {
+    const RunnerConfig &cfg = runner_config();
+    for (int i = 0; i < cfg.warmup; ++i) fn();
+    std::vector<double> xs;
+    for (int i = 0; i < std::max(1, cfg.repetitions); ++i) xs.push_back(fn());
+    return summarize(xs);
+}
+
+// Mean current clock of the CPUs we run on, in MHz (0 if unknown).
+static inline double cpu_mhz() {
+    double sum = 0;
+    int n = 0;
+    for (int c : cpu_order(pin_policy::compact)) {
+        int khz = read_sys_int("/sys/devices/system/cpu/cpu" + std::to_string(c) + "/cpufreq/scaling_cur_freq", -1);
+        if (khz > 0) {
+            sum += khz / 1000.0;
+            ++n;
+        }
+    }
+    if (n > 0) return sum / n;
+
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("cpu MHz", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                sum += std::stod(line.substr(colon + 1));
+                ++n;
+            }
+        }
+    }
+    return n > 0 ? sum / n : 0;
+}
+
+// Run-to-run variation of a fixed spin loop right now, in percent
+// (coefficient of variation): high when other work shares the machine.
+static inline double noise_pct() {
+    const int SAMPLES = 20;
+    std::vector<double> t;
+    for (int s = 0; s < SAMPLES; ++s) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (volatile int i = 0; i < 50000; ++i) {}
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+        t.push_back(d.count());
+    }
+    double mean = 0, var = 0;
+    for (double x : t) mean += x;
+    mean /= SAMPLES;
+    for (double x : t) var += (x - mean) * (x - mean);
+    return mean > 0 ? 100.0 * std::sqrt(var / (SAMPLES - 1)) / mean : 0;
+}
+
+#endif // BENCH_RUNNER_HPP
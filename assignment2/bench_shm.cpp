@@ -0,0 +1,210 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <exception>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "shm_queue.hpp"
+#include "latency_histogram.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Two processes: a forked child produces, the parent consumes, either
+// through a ShmQueue or through a Unix stream socket (one write() per
+// item, reads of up to SOCKET_READ items). Items carry their send time
+// (steady_clock is system-wide), so the parent records end-to-end
+// latency. Rate 0 is as fast as possible; a paced run shows the latency
+// of an almost idle channel. The ShmQueue consumer spins (with backoff)
+// where the socket reader sleeps in read(), so it wants a CPU of its own.
+
+const size_t SHM_CAPACITY = 1024;
+const size_t SOCKET_READ = 64;
+
+struct IpcItem {
+    uint64_t seq;
+    uint64_t sent_ns;
+};
+
+struct IpcPoint {
+    double rate;      // items/s, 0 = unlimited
+    size_t items;
+};
+
+const std::vector<IpcPoint> IPC_POINTS{{0, 1 << 20}, {100000, 1 << 14}};
+
+struct IpcResult {
+    double seconds = 0;
+    LatencyHistogram latency;
+    bool ok = true;
+};
+
+static void send_byte(int fd) {
+    char c = 1;
+    while (write(fd, &c, 1) < 0 && errno == EINTR) {}
+}
+
+static void wait_byte(int fd) {
+    char c;
+    while (read(fd, &c, 1) < 0 && errno == EINTR) {}
+}
+
+// Child side: wait for the go byte, then hand `items` to put() at `rate`.
+template<typename Put>
+static void produce(int go_fd, const IpcPoint &p, Put put) {
+    wait_byte(go_fd);
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> gap(p.rate > 0 ? 1.0 / p.rate : 0);
+    for (size_t i = 0; i < p.items; ++i) {
+        if (p.rate > 0) pace_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(gap * (double)i));
+        put(IpcItem{i, now_ns()});
+    }
+}
+
+static void consume_one(IpcResult &r, const IpcItem &it, uint64_t expected) {
+    r.latency.record(now_ns() - it.sent_ns);
+    if (it.seq != expected) r.ok = false;
+}
+
+// Fork; child(ready_fd, go_fd) runs in the child, which must report
+// ready once it is set up. The parent then starts the clock, sends go and
+// runs consume().
+template<typename Child, typename Consume>
+static IpcResult run_pair(Child child, Consume consume) {
+    int ready[2], go[2];
+    if (pipe(ready) != 0 || pipe(go) != 0) throw std::system_error(errno, std::generic_category(), "pipe");
+    pid_t pid = fork();
+    if (pid < 0) throw std::system_error(errno, std::generic_category(), "fork");
+    if (pid == 0) {
+        int code = 0;
+        try {
+            child(ready[1], go[0]);
+        } catch (const std::exception &e) {
+            std::cerr << "child: " << e.what() << "\n";
+            code = 1;
+        }
+        _exit(code);
+    }
+    close(ready[1]);
+    close(go[0]);
+
+    IpcResult r;
+    wait_byte(ready[0]);
+    auto t0 = std::chrono::steady_clock::now();
+    send_byte(go[1]);
+    consume(r);
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+    r.seconds = d.count();
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) r.ok = false;
+    close(ready[0]);
+    close(go[1]);
+    return r;
+}
+
+static IpcResult run_shm(const IpcPoint &p) {
+    std::string name = "/queue_bench_" + std::to_string(getpid());
+    ShmQueue<IpcItem>::unlink(name);
+    ShmQueue<IpcItem> q = ShmQueue<IpcItem>::create(name, SHM_CAPACITY);
+    IpcResult r = run_pair(
+        [&](int ready_fd, int go_fd) {
+            ShmQueue<IpcItem> mine = ShmQueue<IpcItem>::attach(name);
+            send_byte(ready_fd);
+            produce(go_fd, p, [&](const IpcItem &it) { mine.add(it); });
+        },
+        [&](IpcResult &res) {
+            for (size_t i = 0; i < p.items; ++i) consume_one(res, q.remove(), i);
+        });
+    ShmQueue<IpcItem>::unlink(name);
+    return r;
+}
+
+static IpcResult run_socket(const IpcPoint &p) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) throw std::system_error(errno, std::generic_category(), "socketpair");
+    IpcResult r = run_pair(
+        [&](int ready_fd, int go_fd) {
+            close(sv[0]);
+            send_byte(ready_fd);
+            produce(go_fd, p, [&](const IpcItem &it) {
+                const char *b = reinterpret_cast<const char *>(&it);
+                size_t left = sizeof(it);
+                while (left > 0) {
+                    ssize_t n = write(sv[1], b, left);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) throw std::system_error(errno, std::generic_category(), "write");
+                    b += n;
+                    left -= n;
+                }
+            });
+            close(sv[1]);
+        },
+        [&](IpcResult &res) {
+            close(sv[1]);
+            std::vector<IpcItem> buf(SOCKET_READ);
+            size_t have = 0;       // bytes in buf
+            uint64_t next = 0;
+            while (next < p.items) {
+                ssize_t n = read(sv[0], reinterpret_cast<char *>(buf.data()) + have, buf.size() * sizeof(IpcItem) - have);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    res.ok = false;
+                    break;
+                }
+                have += n;
+                size_t whole = have / sizeof(IpcItem);
+                for (size_t i = 0; i < whole; ++i) consume_one(res, buf[i], next++);
+                // keep a partial item for the next read
+                size_t rest = have - whole * sizeof(IpcItem);
+                std::memmove(buf.data(), reinterpret_cast<char *>(buf.data()) + whole * sizeof(IpcItem), rest);
+                have = rest;
+            }
+            close(sv[0]);
+        });
+    return r;
+}
+
+static void report_ipc(std::ofstream &ofs, const char *name, const IpcPoint &p, const IpcResult &r) {
+    ofs << name << "," << std::setprecision(0) << std::fixed << p.rate << "," << p.items << "," << std::setprecision(6)
+        << r.seconds << "," << std::setprecision(0) << p.items / r.seconds << "," << r.latency.percentile(50) << ","
+        << r.latency.percentile(99) << "," << r.latency.maximum() << "," << (r.ok ? "ok" : "error") << "\n";
+    ofs.flush();
+    std::cout << name << "=" << std::setprecision(6) << r.seconds << "s " << std::flush;
+}
+
+int run_shm_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "transport,rate,items,seconds,items_per_sec,latency_p50_ns,latency_p99_ns,latency_max_ns,status\n";
+
+    bool ok = true;
+    try {
+        for (const IpcPoint &p : IPC_POINTS) {
+            std::cout << "Running rate=" << std::defaultfloat << p.rate << " ... " << std::flush;
+            IpcResult shm = run_shm(p);
+            report_ipc(ofs, "SHM_QUEUE", p, shm);
+            IpcResult sock = run_socket(p);
+            report_ipc(ofs, "UNIX_SOCKET", p, sock);
+            ok = ok && shm.ok && sock.ok;
+            std::cout << "\n";
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "\nIPC benchmark aborted: " << e.what() << "\n";
+        return 2;
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include "blocking_queue.hpp"
+#include "noblocking_queue.hpp"
+#include "ring_storage.hpp"
+#include "bench_runner.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// The mixed workload on the 1<<20-slot rings with each storage policy.
+// Every point builds, prefills, runs and destroys a queue 1 + STEADY_RUNS
+// times in a row. The first time after StorageArena::trim() is the cold,
+// first-touch case; the rest reuse the ring the previous run released
+// (std::allocator rows reuse whatever malloc gives back). Construction,
+// which touches every slot, is timed apart from the run.
+
+const std::vector<int> STORAGE_THREAD_COUNTS{1, 8, 32};
+const double STORAGE_RATIO = 0.5;
+const int STEADY_RUNS = 5;
+
+struct StorageTimes {
+    double construct;
+    double run;
+};
+
+template<typename QueueType>
+static StorageTimes storage_once(const Workload &w) {
+    StorageTimes t;
+    auto t0 = std::chrono::steady_clock::now();
+    std::unique_ptr<QueueType> queue(new QueueType(QUEUE_CAPACITY));
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+    t.construct = d.count();
+
+    shuffle_queue(*queue, w.prefill);
+    t.run = run_workers(w.threads(), [&](size_t tid) {
+        const std::vector<uint8_t> &ops = w.ops[tid];
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (ops[i] == 1) {
+                queue->add(static_cast<int>(i));
+            } else {
+                int val = queue->remove();
+                (void)val;
+            }
+        }
+    });
+    return t;
+}
+
+template<typename QueueType>
+static void report_storage(std::ofstream &ofs, const char *queue, const char *storage, int threads) {
+    Workload w = mixed_workload(threads, STORAGE_RATIO);
+    StorageArena::instance().trim();
+    size_t fallbacks = StorageArena::instance().fallbacks();
+    StorageTimes first = storage_once<QueueType>(w);
+    std::vector<double> construct, run;
+    for (int i = 0; i < STEADY_RUNS; ++i) {
+        StorageTimes t = storage_once<QueueType>(w);
+        construct.push_back(t.construct);
+        run.push_back(t.run);
+    }
+    Summary c = summarize(construct), r = summarize(run);
+    bool fell_back = StorageArena::instance().fallbacks() != fallbacks;
+
+    ofs << queue << "," << storage << "," << threads << "," << std::defaultfloat << STORAGE_RATIO << "," << std::fixed
+        << std::setprecision(6) << first.construct << "," << first.run << "," << c.median << "," << r.median << ","
+        << r.ci_low << "," << r.ci_high << "," << (fell_back ? "transparent" : "-") << "\n";
+    ofs.flush();
+    std::cout << storage << "=" << first.run << "s/" << r.median << "s " << std::flush;
+}
+
+template<template<typename> class Q>
+static void report_storages(std::ofstream &ofs, const char *queue, int threads) {
+    report_storage<Q<std::allocator<int>>>(ofs, queue, "std", threads);
+    report_storage<Q<ring_allocator<int, storage_policy<huge_pages::none, false>>>>(ofs, queue, "mmap_lazy", threads);
+    report_storage<Q<ring_allocator<int, storage_policy<huge_pages::none, true>>>>(ofs, queue, "mmap_prefault", threads);
+    report_storage<Q<ring_allocator<int, storage_policy<huge_pages::transparent, true>>>>(ofs, queue, "thp", threads);
+    report_storage<Q<ring_allocator<int, storage_policy<huge_pages::transparent, true, true>>>>(ofs, queue, "thp_numa",
+                                                                                                 threads);
+    report_storage<Q<ring_allocator<int, storage_policy<huge_pages::explicit_, true>>>>(ofs, queue, "hugetlb", threads);
+}
+
+template<typename Alloc>
+using storage_nbq = NonBlockingQueue<int, nbq_layout<>, spin_wait, Alloc>;
+template<typename Alloc>
+using storage_bq = BlockingQueue<int, Alloc>;
+
+int run_storage_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,storage,threads,ratio,first_construct_s,first_run_s,steady_construct_s,steady_run_s,"
+           "steady_run_ci_low,steady_run_ci_high,hugetlb_fallback\n";
+
+    for (int threads : STORAGE_THREAD_COUNTS) {
+        std::cout << "Running with threads=" << threads << " ... " << std::flush;
+        report_storages<storage_nbq>(ofs, "NONBLOCKING_QUEUE", threads);
+        report_storages<storage_bq>(ofs, "BLOCKING_QUEUE", threads);
+        std::cout << "\n";
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <sys/resource.h>
+
+#include "blocking_queue.hpp"
+#include "noblocking_queue.hpp"
+#include "tbb_queue.hpp"
+#include "ms_queue.hpp"
+#include "faa_queue.hpp"
+#include "random_bits.hpp"
+#include "latency_histogram.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
+
+// Failure paths of the non-blocking and timed operations.
+//
+// try:     the mixed workload with try_add/try_remove on a small queue
+//          and no prefill, so both full and empty are hit; every
+//          operation is attempted once and failures are counted.
+// timeout: try_remove_for on an empty queue (and try_add_for on a full
+//          bounded one); how far past the timeout each call returns and
+//          the CPU it burns while waiting.
+
+const size_t TRY_CAPACITY = 1024;
+const std::vector<int> TRY_THREAD_COUNTS{1, 2, 4, 8, 16, 32};
+
+struct TryResult {
+    double seconds;
+    double add_fail_pct;
+    double remove_fail_pct;
+};
+
+template<typename QueueType>
+static TryResult run_try(size_t threads, double ratio) {
+    QueueType queue(TRY_CAPACITY);
+    // not balanced: hitting empty is the point here, only the seed is shared
+    std::vector<uint8_t> global_ops = generate_random_bits(TOTAL_OPERATIONS, ratio, workload_config().seed);
+    size_t ops_per_thread = TOTAL_OPERATIONS / threads;
+    std::vector<std::array<uint64_t, 4>> counts(threads);   // adds, add fails, removes, remove fails
+
+    TryResult r;
+    r.seconds = run_workers(threads, [&](size_t tid) {
+        uint64_t adds = 0, add_fails = 0, removes = 0, remove_fails = 0;
+        int val;
+        for (size_t i = 0; i < ops_per_thread; ++i) {
+            if (global_ops[tid * ops_per_thread + i] == 1) {
+                ++adds;
+                if (!queue.try_add(static_cast<int>(i))) ++add_fails;
+            } else {
+                ++removes;
+                if (!queue.try_remove(val)) ++remove_fails;
+            }
+        }
+        counts[tid] = {adds, add_fails, removes, remove_fails};
+    });
+
+    uint64_t c[4] = {0, 0, 0, 0};
+    for (const auto &t : counts) {
+        for (int k = 0; k < 4; ++k) c[k] += t[k];
+    }
+    r.add_fail_pct = c[0] ? 100.0 * c[1] / c[0] : 0;
+    r.remove_fail_pct = c[2] ? 100.0 * c[3] / c[2] : 0;
+    return r;
+}
+
+template<typename QueueType>
+static void report_try(std::ofstream &ofs, const char *name, int threads, double ratio) {
+    TryResult r = run_try<QueueType>(threads, ratio);
+    ofs << name << "," << threads << "," << std::defaultfloat << ratio << "," << std::fixed << std::setprecision(6)
+        << r.seconds << "," << std::setprecision(2) << r.add_fail_pct << "," << r.remove_fail_pct << "\n";
+    ofs.flush();
+    std::cout << name << "=" << std::setprecision(6) << r.seconds << "s " << std::flush;
+}
+
+int run_try_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,threads,ratio,seconds,add_fail_pct,remove_fail_pct\n";
+
+    for (auto ratio : RATIO) {
+        std::cout << "Benchmarking try_add/try_remove with ratio=" << ratio << " ... \n";
+        for (int threads : TRY_THREAD_COUNTS) {
+            std::cout << "Running with threads=" << threads << " ... " << std::flush;
+            report_try<BlockingQueue<int>>(ofs, "BLOCKING_QUEUE", threads, ratio);
+            report_try<NonBlockingQueue<int>>(ofs, "NONBLOCKING_QUEUE", threads, ratio);
+            report_try<TBBQueue<int>>(ofs, "TBB_QUEUE", threads, ratio);
+            report_try<MSQueue<int>>(ofs, "MS_QUEUE", threads, ratio);
+            report_try<FAAQueue<int>>(ofs, "FAA_QUEUE", threads, ratio);
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
+
+const std::vector<int> TIMEOUT_WAITERS{1, 4};
+const std::vector<std::chrono::microseconds> TIMEOUTS{
+    std::chrono::microseconds(10), std::chrono::microseconds(100), std::chrono::microseconds(1000)};
+const std::chrono::milliseconds TIMEOUT_BUDGET(50);   // waiting time per waiter and point
+const size_t TIMEOUT_FULL_CAPACITY = 16;
+
+static double cpu_seconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// Every waiter repeatedly times out on `op`; records how late it returned.
+template<typename Op>
+static void run_timeouts(std::ofstream &ofs, const char *name, const char *side, int waiters,
+                         std::chrono::microseconds timeout, Op op) {
+    size_t calls = std::max<size_t>(20, TIMEOUT_BUDGET / timeout);
+    std::vector<LatencyHistogram> late(waiters);
+    std::vector<uint64_t> unexpected(waiters, 0);
+
+    double cpu0 = cpu_seconds();
+    double wall = run_workers(waiters, [&](size_t tid) {
+        for (size_t i = 0; i < calls; ++i) {
+            uint64_t t0 = now_ns();
+            if (op()) {
+                ++unexpected[tid];
+                continue;
+            }
+            uint64_t waited = now_ns() - t0;
+            uint64_t want = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+            late[tid].record(waited > want ? waited - want : 0);
+        }
+    });
+    double cpu = cpu_seconds() - cpu0;
+
+    LatencyHistogram all;
+    uint64_t bad = 0;
+    for (int w = 0; w < waiters; ++w) {
+        all.merge(late[w]);
+        bad += unexpected[w];
+    }
+    ofs << name << "," << side << "," << waiters << "," << timeout.count() << "," << all.percentile(50) << ","
+        << all.percentile(99) << "," << all.maximum() << "," << std::fixed << std::setprecision(3)
+        << cpu / (wall * waiters) << std::defaultfloat << "," << bad << "\n";
+    ofs.flush();
+    std::cout << name << "/" << side << "=" << all.percentile(50) << "ns " << std::flush;
+}
+
+template<typename QueueType>
+static void report_timeout_remove(std::ofstream &ofs, const char *name, int waiters, std::chrono::microseconds timeout) {
+    QueueType queue(TIMEOUT_FULL_CAPACITY);
+    run_timeouts(ofs, name, "remove_empty", waiters, timeout, [&]() {
+        int val;
+        return queue.try_remove_for(val, timeout);
+    });
+}
+
+template<typename QueueType>
+static void report_timeout_add(std::ofstream &ofs, const char *name, int waiters, std::chrono::microseconds timeout) {
+    QueueType queue(TIMEOUT_FULL_CAPACITY);
+    while (queue.try_add(0)) {}
+    run_timeouts(ofs, name, "add_full", waiters, timeout, [&]() { return queue.try_add_for(1, timeout); });
+}
+
+int run_timeout_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
+    }
+    ofs << "queue,side,waiters,timeout_us,late_p50_ns,late_p99_ns,late_max_ns,cpu_per_waiter,unexpected_successes\n";
+
+    typedef NonBlockingQueue<int, nbq_layout<>, eventcount_wait> NonBlockingQueueEC;
+    for (auto timeout : TIMEOUTS) {
+        for (int waiters : TIMEOUT_WAITERS) {
+            std::cout << "Running timeout=" << timeout.count() << "us waiters=" << waiters << " ... " << std::flush;
+            report_timeout_remove<BlockingQueue<int>>(ofs, "BLOCKING_QUEUE", waiters, timeout);
+            report_timeout_remove<NonBlockingQueue<int>>(ofs, "NONBLOCKING_QUEUE", waiters, timeout);
+            report_timeout_remove<NonBlockingQueueEC>(ofs, "NONBLOCKING_QUEUE_EC", waiters, timeout);
+            report_timeout_remove<TBBQueue<int>>(ofs, "TBB_QUEUE", waiters, timeout);
+            report_timeout_remove<TBBQueue<int, eventcount_wait>>(ofs, "TBB_QUEUE_EC", waiters, timeout);
+            report_timeout_remove<MSQueue<int>>(ofs, "MS_QUEUE", waiters, timeout);
+            report_timeout_remove<FAAQueue<int>>(ofs, "FAA_QUEUE", waiters, timeout);
+            // only the bounded queues can be full
+            report_timeout_add<BlockingQueue<int>>(ofs, "BLOCKING_QUEUE", waiters, timeout);
+            report_timeout_add<NonBlockingQueue<int>>(ofs, "NONBLOCKING_QUEUE", waiters, timeout);
+            report_timeout_add<NonBlockingQueueEC>(ofs, "NONBLOCKING_QUEUE_EC", waiters, timeout);
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
@@ -4,16 +4,23 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <stdexcept>
+#include <chrono>
+#include <utility>
+#include <type_traits>
 
-template <typename T>
+#include "slot_storage.hpp"
+#include "queue_stats.hpp"
+
+template <typename T, typename Alloc = std::allocator<T>>
 class BlockingQueue {
 private:
     size_t capacity;
-    std::vector<T> buffer;
+    std::vector<RawSlot<T>, typename std::allocator_traits<Alloc>::template rebind_alloc<RawSlot<T>>> buffer;
     size_t head;
     size_t tail;
     std::atomic<size_t> size;
@@ -21,37 +28,135 @@ private:
     std::mutex tail_mutex;
     std::condition_variable not_empty;
     std::condition_variable not_full;
+    StatCounters<> counters;
 
-public:
-    explicit BlockingQueue(size_t capacity)
-        : capacity(capacity), buffer(capacity), head(0), tail(0), size(0) {}
-    
-    void add(const T &item) {
-        std::unique_lock<std::mutex> tail_lock(tail_mutex);
-        not_full.wait(tail_lock, [this]() {
-            return size.load(std::memory_order_acquire) < capacity;
-        });
+    bool has_room() const { return size.load(std::memory_order_acquire) < capacity; }
+    bool has_item() const { return size.load(std::memory_order_acquire) > 0; }
 
-        buffer[tail] = item;
+    // caller holds tail_mutex and has checked has_room()
+    template <typename... Args>
+    void push_locked(Args &&...args) {
+        buffer[tail].emplace(std::forward<Args>(args)...);
         tail = (tail + 1) % capacity;
         size.fetch_add(1, std::memory_order_release);
 
         not_empty.notify_one();
-    }   
-
-    T remove() {
-        std::unique_lock<std::mutex> head_lock(head_mutex);
-        not_empty.wait(head_lock, [this]() {
-            return size.load(std::memory_order_acquire) > 0;    
-        });
+        counters.add(stat_cv_notify);
+    }
 
-        T out = buffer[head];
+    // caller holds head_mutex and has checked has_item()
+    T pop_locked() {
+        T out = buffer[head].take();
         head = (head + 1) % capacity;
         size.fetch_sub(1, std::memory_order_release);
 
         not_full.notify_one();
+        counters.add(stat_cv_notify);
         return out;
     }
+
+    // Wait on cv (lock held) until ready(). A call that has to wait counts
+    // one `side` wait, then one cv_wait per wakeup; the timed overload
+    // counts the same and returns false if deadline passes first.
+    template <typename Ready>
+    void wait_counted(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, queue_stat side, Ready ready) {
+        if (ready()) return;
+        counters.add(side);
+        do {
+            counters.add(stat_cv_wait);
+            cv.wait(lock);
+        } while (!ready());
+    }
+
+    template <typename Ready>
+    bool wait_counted(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, queue_stat side, Ready ready,
+                      std::chrono::steady_clock::time_point deadline) {
+        if (ready()) return true;
+        counters.add(side);
+        do {
+            counters.add(stat_cv_wait);
+            if (cv.wait_until(lock, deadline) == std::cv_status::timeout) return ready();
+        } while (!ready());
+        return true;
+    }
+
+public:
+    typedef T value_type;
+
+    explicit BlockingQueue(size_t capacity)
+        : capacity(capacity), buffer(capacity), head(0), tail(0), size(0) {}
+
+    ~BlockingQueue() {
+        if (std::is_trivially_destructible<T>::value) return;
+        for (size_t i = 0, n = size.load(); i < n; ++i) {
+            buffer[(head + i) % capacity].destroy();
+        }
+    }
+
+    QueueStats stats() const { return counters.merged(); }
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        std::unique_lock<std::mutex> tail_lock(tail_mutex);
+        wait_counted(not_full, tail_lock, stat_full_wait, [this]() { return has_room(); });
+        push_locked(std::forward<Args>(args)...);
+    }
+
+    T remove() {
+        std::unique_lock<std::mutex> head_lock(head_mutex);
+        wait_counted(not_empty, head_lock, stat_empty_wait, [this]() { return has_item(); });
+        return pop_locked();
+    }
+
+    bool try_add(const T &item) { return try_emplace(item); }
+    bool try_add(T &&item) { return try_emplace(std::move(item)); }
+
+    template <typename... Args>
+    bool try_emplace(Args &&...args) {
+        std::unique_lock<std::mutex> tail_lock(tail_mutex);
+        if (!has_room()) return false;
+        push_locked(std::forward<Args>(args)...);
+        return true;
+    }
+
+    bool try_remove(T &out) {
+        std::unique_lock<std::mutex> head_lock(head_mutex);
+        if (!has_item()) return false;
+        out = pop_locked();
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> tail_lock(tail_mutex);
+        if (!wait_counted(not_full, tail_lock, stat_full_wait, [this]() { return has_room(); }, deadline)) return false;
+        push_locked(item);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(T &&item, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> tail_lock(tail_mutex);
+        if (!wait_counted(not_full, tail_lock, stat_full_wait, [this]() { return has_room(); }, deadline)) return false;
+        push_locked(std::move(item));
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> head_lock(head_mutex);
+        if (!wait_counted(not_empty, head_lock, stat_empty_wait, [this]() { return has_item(); }, deadline)) {
+            return false;
+        }
+        out = pop_locked();
+        return true;
+    }
 };
 
 #endif // BLOCKING_QUEUE_HPP
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef CHASE_LEV_DEQUE_HPP
+#define CHASE_LEV_DEQUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include "ebr.hpp"
+
+// Work-stealing deque (Chase & Lev, SPAA '05), with the memory orders of
+// Lê, Pop, Cohen & Zappa Nardelli, "Correct and Efficient Work-Stealing
+// for Weak Memory Models" (PPoPP '13).
+//
+// One owner thread push()es and pop()s at the bottom; any thread may
+// steal() from the top. The circular array doubles when the owner finds
+// it full. Thieves may still be reading the old array, so it is retired
+// through ebr and steal() runs inside a guard.
+//
+// T is copied with plain atomic loads and stores, so it has to be
+// trivially copyable; in practice it is a pointer to the task.
+template <typename T>
+class ChaseLevDeque {
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "ChaseLevDeque holds trivially copyable values");
+
+    struct Ring {
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Ring(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+        size_t capacity() const { return mask + 1; }
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T x) { slots[i & mask].store(x, std::memory_order_relaxed); }
+    };
+
+    static void free_ring(void *p) { delete static_cast<Ring *>(p); }
+
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::atomic<Ring *> ring;
+
+    Ring *grow(Ring *old, int64_t b, int64_t t) {
+        Ring *bigger = new Ring(old->capacity() * 2);
+        for (int64_t i = t; i < b; ++i) bigger->put(i, old->get(i));
+        ring.store(bigger, std::memory_order_release);
+        ebr::retire(old, &ChaseLevDeque::free_ring);
+        return bigger;
+    }
+
+public:
+    // capacity is rounded up to a power of two
+    explicit ChaseLevDeque(size_t capacity = 1024) {
+        size_t c = 1;
+        while (c < capacity) c <<= 1;
+        ring.store(new Ring(c), std::memory_order_relaxed);
+    }
+
+    ~ChaseLevDeque() { delete ring.load(std::memory_order_relaxed); }
+
+    ChaseLevDeque(const ChaseLevDeque &) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+    // owner only
+    void push(T x) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Ring *a = ring.load(std::memory_order_relaxed);
+        if (b - t > (int64_t)a->mask) a = grow(a, b, t);
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only; newest item first
+    bool pop(T &out) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring *a = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // last item: race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread; oldest item first. Also false when it lost a race, so
+    // an empty result does not prove the deque is empty.
+    bool steal(T &out) {
+        ebr::Guard guard;
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Ring *a = ring.load(std::memory_order_acquire);
+        T x = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = x;
+        return true;
+    }
+
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // CHASE_LEV_DEQUE_HPP
@@ -0,0 +1,143 @@
+#ifndef EBR_HPP
+#define EBR_HPP
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Epoch-based reclamation for the lock-free queues.
+//
+// A thread reads shared nodes only inside an ebr::Guard. Unlinked nodes are
+// handed to ebr::retire() and freed once the global epoch has moved two
+// steps past the epoch they were retired in: by then every thread that
+// could still hold a pointer to them has left its guard.
+//
+// Thread records are never freed; a record is released when its thread
+// exits and picked up again, with whatever it still has to free, by the
+// next new thread.
+//
+// Everything below is inline, not static: all translation units must share
+// one epoch, one record list and one record per thread.
+namespace ebr {
+
+const size_t RETIRE_BATCH = 64;   // retires between attempts to advance the epoch
+
+struct Retired {
+    void *ptr;
+    void (*deleter)(void *);
+};
+
+struct alignas(64) Record {
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> active{false};
+    std::atomic<bool> in_use{true};
+    Record *next = nullptr;
+
+    // owner thread only
+    int depth = 0;
+    size_t since_advance = 0;
+    std::vector<Retired> bags[3];
+    uint64_t bag_epoch[3] = {0, 0, 0};
+};
+
+inline std::atomic<uint64_t> &global_epoch() {
+    static std::atomic<uint64_t> e{2};
+    return e;
+}
+
+inline std::atomic<Record *> &records() {
+    static std::atomic<Record *> head{nullptr};
+    return head;
+}
+
+inline Record *acquire_record() {
+    for (Record *r = records().load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    Record *r = new Record;
+    Record *head = records().load(std::memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!records().compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    return r;
+}
+
+struct ThreadHandle {
+    Record *rec = acquire_record();
+    ~ThreadHandle() { rec->in_use.store(false, std::memory_order_release); }
+};
+
+inline Record &self() {
+    static thread_local ThreadHandle handle;
+    return *handle.rec;
+}
+
+inline void free_bag(Record &r, int i) {
+    for (const Retired &x : r.bags[i]) x.deleter(x.ptr);
+    r.bags[i].clear();
+}
+
+// Bump the global epoch if every active thread has already seen it.
+inline void try_advance() {
+    uint64_t e = global_epoch().load(std::memory_order_seq_cst);
+    for (Record *r = records().load(std::memory_order_acquire); r; r = r->next) {
+        if (r->active.load(std::memory_order_seq_cst) && r->epoch.load(std::memory_order_seq_cst) != e) {
+            return;
+        }
+    }
+    global_epoch().compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+}
+
+inline void enter() {
+    Record &r = self();
+    if (r.depth++ > 0) return;
+    r.active.store(true, std::memory_order_seq_cst);
+    uint64_t e = global_epoch().load(std::memory_order_seq_cst);
+    r.epoch.store(e, std::memory_order_seq_cst);
+    for (int i = 0; i < 3; ++i) {
+        if (!r.bags[i].empty() && r.bag_epoch[i] + 2 <= e) free_bag(r, i);
+    }
+}
+
+inline void leave() {
+    Record &r = self();
+    if (--r.depth > 0) return;
+    r.active.store(false, std::memory_order_release);
+}
+
+// Call after ptr has been unlinked. It is tagged with the global epoch
+// read here, which is at least the epoch of anyone still holding it.
+inline void retire(void *ptr, void (*deleter)(void *)) {
+    Record &r = self();
+    uint64_t e = global_epoch().load(std::memory_order_seq_cst);
+    int i = e % 3;
+    if (r.bag_epoch[i] != e) {
+        // the bag left over from epoch e-3 is safe by now
+        free_bag(r, i);
+        r.bag_epoch[i] = e;
+    }
+    r.bags[i].push_back({ptr, deleter});
+    if (++r.since_advance >= RETIRE_BATCH) {
+        r.since_advance = 0;
+        try_advance();
+    }
+}
+
+class Guard {
+public:
+    Guard() { enter(); }
+    ~Guard() { leave(); }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+};
+
+} // namespace ebr
+
+#endif // EBR_HPP
@@ -0,0 +1,177 @@
+#ifndef EVENTCOUNT_HPP
+#define EVENTCOUNT_HPP
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <climits>
+#include <cstdint>
+#include <chrono>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static inline void futex_wait(std::atomic<uint32_t> *addr, uint32_t expected,
+                              const struct timespec *timeout = nullptr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+static inline void futex_wake(std::atomic<uint32_t> *addr, int n) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+}
+
+// 退避 让步: a short pause loop, then yield; true if it yielded
+static inline bool spin_backoff() {
+    static thread_local int spins = 0;
+    if (++spins < 16) {
+        for (volatile int i = 0; i < 30; ++i) {
+            asm volatile("":::"memory");
+        }
+        return false;
+    }
+    std::this_thread::yield();
+    if (spins > 1024) spins = 0;
+    return true;
+}
+
+// Eventcount: lets a thread sleep until a lock-free condition may have
+// become true, without a mutex on the signalling side.
+//
+//   waiter:                         notifier:
+//     key = ec.prepare_wait();        publish the change
+//     if (ready()) ec.cancel_wait();  ec.notify_one();
+//     else         ec.wait(key);
+//
+// prepare_wait registers the waiter before the re-check, and notify looks
+// at the waiter count only after the change is published, so one of the
+// two always sees the other. notify costs a fence and a load while nobody
+// is registered; it bumps the epoch and calls futex_wake only if somebody
+// is.
+class EventCount {
+private:
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> waiters{0};
+
+    void notify(int n) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) != 0) {
+            epoch.fetch_add(1, std::memory_order_release);
+            futex_wake(&epoch, n);
+        }
+    }
+
+public:
+    typedef uint32_t Key;
+
+    Key prepare_wait() {
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_acquire);
+    }
+
+    void cancel_wait() {
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // sleeps until a notify after prepare_wait returned key
+    void wait(Key key) {
+        while (epoch.load(std::memory_order_acquire) == key) {
+            futex_wait(&epoch, key);
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // like wait, but gives up at deadline; false if it timed out
+    bool wait_until(Key key, std::chrono::steady_clock::time_point deadline) {
+        bool notified = true;
+        while (epoch.load(std::memory_order_acquire) == key) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero()) {
+                notified = false;
+                break;
+            }
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+            struct timespec ts;
+            ts.tv_sec = ns / 1000000000;
+            ts.tv_nsec = ns % 1000000000;
+            futex_wait(&epoch, key, &ts);
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return notified;
+    }
+
+    void notify_one() { notify(1); }
+    void notify_all() { notify(INT_MAX); }
+};
+
+// Wait policies for the queues. await(ready) returns when it is worth
+// retrying the operation; the caller re-checks either way. await_until
+// also returns once deadline has passed. Both return true if the thread
+// gave up the CPU (yielded or slept) on the way.
+
+// Original behaviour: one backoff step, notifications are free.
+struct spin_wait {
+    static constexpr const char *name = "spin";
+
+    template <typename Ready>
+    bool await(Ready) { return spin_backoff(); }
+
+    template <typename Ready>
+    bool await_until(Ready, std::chrono::steady_clock::time_point) { return spin_backoff(); }
+
+    void notify_one() {}
+    void notify_all() {}
+};
+
+// Spin for a while, then sleep on an eventcount until ready() holds.
+struct eventcount_wait {
+    static constexpr const char *name = "eventcount";
+    static constexpr int SPINS = 64;
+
+    EventCount ec;
+
+    template <typename Ready>
+    bool await(Ready ready) {
+        bool gave_up = false;
+        for (int i = 0; i < SPINS; ++i) {
+            if (ready()) return gave_up;
+            gave_up |= spin_backoff();
+        }
+        while (!ready()) {
+            EventCount::Key key = ec.prepare_wait();
+            if (ready()) {
+                ec.cancel_wait();
+                break;
+            }
+            ec.wait(key);
+            gave_up = true;
+        }
+        return gave_up;
+    }
+
+    template <typename Ready>
+    bool await_until(Ready ready, std::chrono::steady_clock::time_point deadline) {
+        bool gave_up = false;
+        for (int i = 0; i < SPINS; ++i) {
+            if (ready() || std::chrono::steady_clock::now() >= deadline) return gave_up;
+            gave_up |= spin_backoff();
+        }
+        while (!ready()) {
+            EventCount::Key key = ec.prepare_wait();
+            if (ready()) {
+                ec.cancel_wait();
+                break;
+            }
+            gave_up = true;
+            if (!ec.wait_until(key, deadline)) break;
+        }
+        return gave_up;
+    }
+
+    void notify_one() { ec.notify_one(); }
+    void notify_all() { ec.notify_all(); }
+};
+
+#endif // EVENTCOUNT_HPP
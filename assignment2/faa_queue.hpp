@@ -0,0 +1,204 @@
+#ifndef FAA_QUEUE_HPP
+#define FAA_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <chrono>
+
+#include "ebr.hpp"
+#include "eventcount.hpp"
+#include "slot_storage.hpp"
+#include "queue_stats.hpp"
+#include "queue_ops.hpp"
+
+// Unbounded MPMC queue built from linked ring segments, in the style of
+// LCRQ (Morrison & Afek) and the FAA array queue.
+//
+// Producers and consumers claim slot indices with fetch_add on the
+// segment's enq/deq counters, so a contended operation never has to retry
+// its claim. The only retry is when a consumer overtakes a slow producer on
+// the same slot: it marks the slot TAKEN and both move on to new indices.
+// A full segment is followed by a fresh one linked onto its next pointer;
+// exhausted segments are retired through ebr.
+//
+// LCRQ closes and reuses each ring with a double-width CAS; here a segment
+// is used once and dropped, which keeps every step a single-word atomic.
+template <typename T, typename Wait = spin_wait>
+class FAAQueue : public unbounded_add<FAAQueue<T, Wait>, T> {
+private:
+    static const size_t SEGMENT_SIZE = 1024;
+    static const int SLOT_SPINS = 128;   // how long a consumer waits for a claimed slot
+
+    enum : uint32_t { EMPTY = 0, FULL = 1, TAKEN = 2 };
+
+    // data holds a value exactly while state is FULL
+    struct Slot {
+        std::atomic<uint32_t> state{EMPTY};
+        RawSlot<T> data;
+    };
+
+    struct Segment {
+        alignas(64) std::atomic<size_t> enq{0};
+        alignas(64) std::atomic<size_t> deq{0};
+        alignas(64) std::atomic<Segment *> next{nullptr};
+        Slot slots[SEGMENT_SIZE];
+    };
+
+    static void free_segment(void *p) { delete static_cast<Segment *>(p); }
+
+    alignas(64) std::atomic<Segment *> head;
+    alignas(64) std::atomic<Segment *> tail;
+    alignas(64) Wait not_empty;
+    StatCounters<> counters;
+
+    // Claim the front slot; its value then belongs to the caller, who must
+    // take it before leaving the guard this is called in. nullptr if empty.
+    Slot *claim_front() {
+        while (true) {
+            Segment *h = head.load(std::memory_order_acquire);
+            if (h->deq.load(std::memory_order_relaxed) >= h->enq.load(std::memory_order_relaxed) &&
+                h->next.load(std::memory_order_acquire) == nullptr) {
+                return nullptr;
+            }
+            size_t i = h->deq.fetch_add(1, std::memory_order_relaxed);
+            if (i < SEGMENT_SIZE) {
+                Slot &s = h->slots[i];
+                // a producer holding this index is probably about to fill it
+                for (int k = 0; k < SLOT_SPINS && s.state.load(std::memory_order_acquire) == EMPTY &&
+                                i < h->enq.load(std::memory_order_relaxed); ++k) {
+                    asm volatile("":::"memory");
+                }
+                if (s.state.exchange(TAKEN, std::memory_order_acq_rel) == FULL) return &s;
+                // overtook its producer
+                counters.add(stat_retry);
+                continue;
+            }
+
+            // segment used up
+            Segment *next = h->next.load(std::memory_order_acquire);
+            if (next == nullptr) return nullptr;
+            // tail must not be left pointing at a segment we retire
+            Segment *t = h;
+            tail.compare_exchange_strong(t, next, std::memory_order_release, std::memory_order_relaxed);
+            if (head.compare_exchange_strong(h, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                ebr::retire(h, &FAAQueue::free_segment);
+            } else {
+                counters.add(stat_head_cas_fail);
+            }
+        }
+    }
+
+public:
+    typedef T value_type;
+
+    explicit FAAQueue(size_t) {
+        Segment *seg = new Segment;
+        head.store(seg, std::memory_order_relaxed);
+        tail.store(seg, std::memory_order_relaxed);
+    }
+
+    ~FAAQueue() {
+        Segment *s = head.load(std::memory_order_relaxed);
+        while (s) {
+            Segment *next = s->next.load(std::memory_order_relaxed);
+            for (Slot &slot : s->slots) {
+                if (slot.state.load(std::memory_order_relaxed) == FULL) slot.data.destroy();
+            }
+            delete s;
+            s = next;
+        }
+    }
+
+    FAAQueue(const FAAQueue &) = delete;
+    FAAQueue &operator=(const FAAQueue &) = delete;
+
+    QueueStats stats() const { return counters.merged(); }
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    // The value is built once up front: a slot claim can fail, and the
+    // value then has to move back out and on to the next index.
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        RawSlot<T> item;
+        item.emplace(std::forward<Args>(args)...);
+
+        ebr::Guard guard;
+        while (true) {
+            Segment *t = tail.load(std::memory_order_acquire);
+            size_t i = t->enq.fetch_add(1, std::memory_order_relaxed);
+            if (i < SEGMENT_SIZE) {
+                Slot &s = t->slots[i];
+                s.data.emplace(item.take());
+                uint32_t expected = EMPTY;
+                if (s.state.compare_exchange_strong(expected, FULL, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+                    break;
+                }
+                // a consumer gave up waiting on this slot
+                item.emplace(s.data.take());
+                counters.add(stat_retry);
+                continue;
+            }
+
+            // segment full: move on to the next one, appending it if needed
+            if (t != tail.load(std::memory_order_acquire)) continue;
+            Segment *next = t->next.load(std::memory_order_acquire);
+            if (next) {
+                tail.compare_exchange_strong(t, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            Segment *seg = new Segment;
+            seg->enq.store(1, std::memory_order_relaxed);
+            seg->slots[0].data.emplace(item.take());
+            seg->slots[0].state.store(FULL, std::memory_order_relaxed);
+            if (t->next.compare_exchange_strong(next, seg, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+                tail.compare_exchange_strong(t, seg, std::memory_order_release, std::memory_order_relaxed);
+                break;
+            }
+            item.emplace(seg->slots[0].data.take());
+            delete seg;
+            counters.add(stat_tail_cas_fail);
+        }
+        not_empty.notify_one();
+    }
+
+    bool try_remove(T &out) {
+        ebr::Guard guard;
+        Slot *s = claim_front();
+        if (!s) return false;
+        out = s->data.take();
+        return true;
+    }
+
+    T remove() {
+        while (true) {
+            {
+                ebr::Guard guard;
+                if (Slot *s = claim_front()) return s->data.take();
+            }
+            counters.empty_wait(not_empty.await([this]() { return !empty(); }));
+        }
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        return retry_until(not_empty, std::chrono::steady_clock::now() + timeout, [&]() { return try_remove(out); },
+                           [this]() { return !empty(); }, [this](bool gave_up) { counters.empty_wait(gave_up); });
+    }
+
+    bool empty() const {
+        ebr::Guard guard;
+        Segment *h = head.load(std::memory_order_acquire);
+        size_t deq = h->deq.load(std::memory_order_relaxed);
+        return deq >= h->enq.load(std::memory_order_relaxed) && h->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // FAA_QUEUE_HPP
@@ -0,0 +1,244 @@
+#ifndef FC_QUEUE_HPP
+#define FC_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include "eventcount.hpp"
+#include "slot_storage.hpp"
+#include "queue_stats.hpp"
+
+// Bounded flat-combining queue (Hendler, Incze, Shavit & Tzafrir,
+// SPAA '10).
+//
+// A thread publishes its operation in its own request slot and then
+// either waits for the slot to be answered or, if the combiner lock is
+// free, takes it and answers every pending request in one pass over the
+// slots against a plain sequential ring. Under contention one thread
+// does all the work while the ring, head and tail stay in its cache; the
+// others spin on their own slot's cache line.
+//
+// Each thread gets a slot the first time it uses a queue and keeps it for
+// the queue's lifetime, so at most MAX_THREADS different threads may ever
+// use one queue; one more throws std::length_error from add / remove.
+// Callers that can exceed it check MAX_THREADS up front.
+inline std::atomic<uint64_t> &fc_queue_ids() {
+    static std::atomic<uint64_t> next{1};
+    return next;
+}
+
+template <typename T>
+class FlatCombiningQueue {
+public:
+    static constexpr size_t MAX_THREADS = 256;
+
+private:
+    static constexpr int COMBINE_PASSES = 4;   // passes while they keep answering requests
+
+    enum : uint32_t { IDLE, ADD, TRY_ADD, REMOVE, TRY_REMOVE, DONE, FAILED };
+
+    // item carries the value to add in, or the removed value out
+    struct alignas(64) Request {
+        std::atomic<uint32_t> state{IDLE};
+        RawSlot<T> item;
+    };
+
+    struct Owned {
+        uint64_t queue;
+        size_t slot;
+    };
+
+    const uint64_t id;
+    size_t capacity;
+    std::vector<RawSlot<T>> buffer;
+    size_t head = 0;       // combiner only
+    size_t count = 0;      // combiner only
+    std::unique_ptr<Request[]> requests;
+    alignas(64) std::atomic<size_t> registered{0};
+    alignas(64) std::atomic<bool> combining{false};
+    StatCounters<> counters;
+
+    Request &my_request() {
+        static thread_local std::vector<Owned> mine;
+        for (size_t i = mine.size(); i-- > 0;) {
+            if (mine[i].queue == id) return requests[mine[i].slot];
+        }
+        size_t s = registered.fetch_add(1, std::memory_order_relaxed);
+        if (s >= MAX_THREADS) throw std::length_error("FlatCombiningQueue: too many threads");
+        mine.push_back(Owned{id, s});
+        return requests[s];
+    }
+
+    // one request against the ring; false if it has to stay pending
+    bool serve(Request &r, uint32_t op) {
+        if (op == ADD || op == TRY_ADD) {
+            if (count == capacity) {
+                if (op == ADD) return false;
+                r.state.store(FAILED, std::memory_order_release);
+                return true;
+            }
+            buffer[(head + count) % capacity].emplace(r.item.take());
+            ++count;
+        } else {
+            if (count == 0) {
+                if (op == REMOVE) return false;
+                r.state.store(FAILED, std::memory_order_release);
+                return true;
+            }
+            r.item.emplace(buffer[head].take());
+            head = (head + 1) % capacity;
+            --count;
+        }
+        r.state.store(DONE, std::memory_order_release);
+        return true;
+    }
+
+    void combine() {
+        size_t n = std::min(registered.load(std::memory_order_acquire), MAX_THREADS);
+        for (int pass = 0; pass < COMBINE_PASSES; ++pass) {
+            bool progress = false;
+            for (size_t i = 0; i < n; ++i) {
+                Request &r = requests[i];
+                uint32_t op = r.state.load(std::memory_order_acquire);
+                if (op >= ADD && op <= TRY_REMOVE && serve(r, op)) progress = true;
+            }
+            if (!progress) break;
+        }
+    }
+
+    // publish op and wait until it is DONE or FAILED, combining when we can
+    bool submit(Request &r, uint32_t op) {
+        r.state.store(op, std::memory_order_release);
+        while (true) {
+            uint32_t s = r.state.load(std::memory_order_acquire);
+            if (s == DONE || s == FAILED) {
+                r.state.store(IDLE, std::memory_order_relaxed);
+                return s == DONE;
+            }
+            if (!combining.load(std::memory_order_relaxed) &&
+                !combining.exchange(true, std::memory_order_acquire)) {
+                combine();
+                combining.store(false, std::memory_order_release);
+                s = r.state.load(std::memory_order_relaxed);
+                // still pending after our own pass: full or empty
+                if (s != DONE && s != FAILED) {
+                    bool yielded = spin_backoff();
+                    if (op == ADD) counters.full_wait(yielded);
+                    else counters.empty_wait(yielded);
+                }
+            } else {
+                // another thread is combining
+                counters.add(stat_retry);
+                if (spin_backoff()) counters.add(stat_yield);
+            }
+        }
+    }
+
+    template <typename... Args>
+    bool emplace_as(uint32_t op, Args &&...args) {
+        Request &r = my_request();
+        r.item.emplace(std::forward<Args>(args)...);
+        if (submit(r, op)) return true;
+        r.item.destroy();
+        return false;
+    }
+
+    // item is moved in, and moved back if the queue was full
+    bool try_add_moved(T &item) {
+        Request &r = my_request();
+        r.item.emplace(std::move(item));
+        if (submit(r, TRY_ADD)) return true;
+        item = r.item.take();
+        return false;
+    }
+
+    bool remove_as(uint32_t op, T &out) {
+        Request &r = my_request();
+        if (!submit(r, op)) return false;
+        out = r.item.take();
+        return true;
+    }
+
+public:
+    typedef T value_type;
+
+    explicit FlatCombiningQueue(size_t capacity)
+        : id(fc_queue_ids().fetch_add(1, std::memory_order_relaxed)), capacity(capacity), buffer(capacity),
+          requests(new Request[MAX_THREADS]) {}
+
+    ~FlatCombiningQueue() {
+        if (std::is_trivially_destructible<T>::value) return;
+        for (size_t i = 0; i < count; ++i) buffer[(head + i) % capacity].destroy();
+    }
+
+    FlatCombiningQueue(const FlatCombiningQueue &) = delete;
+    FlatCombiningQueue &operator=(const FlatCombiningQueue &) = delete;
+
+    QueueStats stats() const { return counters.merged(); }
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        emplace_as(ADD, std::forward<Args>(args)...);
+    }
+
+    T remove() {
+        Request &r = my_request();
+        submit(r, REMOVE);
+        return r.item.take();
+    }
+
+    bool try_add(const T &item) { return emplace_as(TRY_ADD, item); }
+    bool try_add(T &&item) { return try_add_moved(item); }
+
+    // on failure the value built from args is dropped
+    template <typename... Args>
+    bool try_emplace(Args &&...args) {
+        return emplace_as(TRY_ADD, std::forward<Args>(args)...);
+    }
+
+    bool try_remove(T &out) { return remove_as(TRY_REMOVE, out); }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_add(item)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            spin_backoff();
+        }
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(T &&item, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_add_moved(item)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            spin_backoff();
+        }
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_remove(out)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            spin_backoff();
+        }
+        return true;
+    }
+};
+
+#endif // FC_QUEUE_HPP
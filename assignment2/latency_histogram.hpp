@@ -0,0 +1,78 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+static inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Log-linear (HDR style) histogram of nanosecond values: exact below 32,
+// then 32 sub-buckets per power of two, i.e. about 3% relative error.
+// One per thread, merged after the run.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    static int bucket_of(uint64_t v) {
+        if (v < (uint64_t)SUB_COUNT) return (int)v;
+        int e = 63 - __builtin_clzll(v);
+        int sub = (int)((v >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+        return (e - SUB_BITS + 1) * SUB_COUNT + sub;
+    }
+
+    // highest value that maps to bucket b
+    static uint64_t bucket_upper(int b) {
+        if (b < SUB_COUNT) return (uint64_t)b;
+        int e = b / SUB_COUNT + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(b % SUB_COUNT);
+        uint64_t lower = (SUB_COUNT + sub) << (e - SUB_BITS);
+        return lower + ((uint64_t)1 << (e - SUB_BITS)) - 1;
+    }
+
+    LatencyHistogram() : counts(BUCKETS, 0) {}
+
+    void record(uint64_t v) {
+        ++counts[bucket_of(v)];
+        ++total;
+        if (v > max) max = v;
+    }
+
+    void merge(const LatencyHistogram &o) {
+        for (int b = 0; b < BUCKETS; ++b) counts[b] += o.counts[b];
+        total += o.total;
+        if (o.max > max) max = o.max;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t maximum() const { return max; }
+
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * total);
+        if (rank >= total) rank = total - 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen > rank) {
+                uint64_t hi = bucket_upper(b);
+                return hi < max ? hi : max;
+            }
+        }
+        return max;
+    }
+
+private:
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -12,209 +12,301 @@
 #include <system_error>
 #include <cstring>
 #include <exception>
+#include <stdexcept>
 
 #include "blocking_queue.hpp"
 #include "noblocking_queue.hpp"
 #include "tbb_queue.hpp"
-#include "random_bits.hpp"
+#include "ms_queue.hpp"
+#include "faa_queue.hpp"
+#include "fc_queue.hpp"
+#include "bench_common.hpp"
+#include "bench_modes.hpp"
 
 #include <cstdint>
-#include <random>
-
-static inline std::vector<uint8_t> generate_ops_patterned(size_t total_ops) {
-    std::vector<uint8_t> v;
-    v.reserve(total_ops);
-    // 定义模式：pair<count, op>，op: 1=enq, 0=deq
-    const std::vector<std::pair<size_t,uint8_t>> pattern = {
-        {1024, 1}, // 1000 enq
-        {512,  0}, // 500 deq
-        {1024,  1}, // 500 enq
-        {1536, 0}  // 1000 deq
-    };
-    while (v.size() < total_ops) {
-        for (const auto &p : pattern) {
-            size_t cnt = p.first;
-            uint8_t op = p.second;
-            for (size_t i = 0; i < cnt && v.size() < total_ops; ++i) {
-                v.push_back(op);
+
+// Runs workload w on a fresh queue; stats, if given, gets the queue's
+// telemetry counters added to it
+template<typename QueueType>
+double run_benchmark_queue(const Workload &w, QueueStats *stats = nullptr) {
+    // create queue
+    QueueType queue(QUEUE_CAPACITY);
+    shuffle_queue(queue, w.prefill);
+
+    size_t threads = w.threads();
+    std::vector<std::vector<int>> per_thread_values(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        per_thread_values[t].resize(w.ops[t].size());
+        std::iota(per_thread_values[t].begin(), per_thread_values[t].end(), static_cast<int>(t * 100000));
+    }
+
+    double t = run_workers(threads, [&](size_t tid) {
+        const std::vector<uint8_t> &ops = w.ops[tid];
+        for (size_t i = 0; i < ops.size(); ++i) {
+            uint8_t op = ops[i];
+            if (op == 1) { // enqueue
+                queue.add(per_thread_values[tid][i]);
+            } else { // dequeue
+                int val = queue.remove();
+                (void)val; // 防止未使用警告
             }
-            if (v.size() >= total_ops) break;
         }
-    }
-    return v;
+    });
+    if (stats) *stats += queue.stats();
+    return t;
 }
 
+// One mixed-mode point: warmup + repetitions, median and its 95% CI,
+// plus the machine state it was measured under and, with QUEUE_STATS,
+// the queue's counters averaged over all runs (empty columns otherwise).
 template<typename QueueType>
-static inline void shuffle_queue(QueueType &queue, size_t eqn_count) {
-    while (eqn_count > 0) {
-        int random_ = rand() % 1000000;
-        queue.add(random_);
-        --eqn_count;
+static void report_mixed(std::ofstream &ofs, const char *name, const char *label, const Workload &w) {
+    double mhz = cpu_mhz();
+    double noise = noise_pct();
+    QueueStats stats;
+    int runs = 0;
+    Summary s = measure([&]() {
+        ++runs;
+        return run_benchmark_queue<QueueType>(w, &stats);
+    });
+    ofs << name << "," << w.threads() << "," << std::defaultfloat << w.ratio << "," << workload_name(w.kind) << ","
+        << w.seed << "," << std::fixed << std::setprecision(6)
+        << s.median << "," << s.ci_low << "," << s.ci_high << "," << s.n << "," << pin_name(runner_config().pin)
+        << "," << std::setprecision(0) << mhz << "," << std::setprecision(2) << noise;
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        ofs << ",";
+        if (StatCounters<>::enabled) ofs << std::setprecision(0) << (double)stats.count[i] / runs;
     }
+    ofs << "\n";
+    ofs.flush();
+    std::cout << label << "=" << std::setprecision(6) << s.median << "s " << std::flush;
 }
 
-const size_t TOTAL_OPERATIONS = 1<< 20; 
-const size_t QUEUE_CAPACITY = 1 << 20; // 队列容量
-const std::vector<double> RATIO{0.3, 0.5, 0.8}; // 不同入队出队比例
-const std::vector<int> THREAD_COUNTS = [](){
-    std::vector<int> v;
-    for (int i = 1; i <= 32; ++i) v.push_back(i);
-    return v;
-}();
+static void write_mixed_header(std::ofstream &ofs) {
+    ofs << "queue,threads,ratio,workload,seed,seconds,seconds_ci_low,seconds_ci_high,repetitions,pin,cpu_mhz,"
+           "noise_pct";
+    for (int i = 0; i < STAT_COUNT; ++i) ofs << "," << stat_name(i);
+    ofs << "\n";
+}
 
-template<typename QueueType>
-double run_benchmark_queue(size_t threads, double ratio) {
-    // create queue
-    QueueType queue(QUEUE_CAPACITY);
+// Most worker threads report_mixed_queues can run: FlatCombiningQueue's
+// slots, less the one the main thread takes while prefilling.
+const size_t MIXED_MAX_THREADS = FlatCombiningQueue<int>::MAX_THREADS - 1;
 
-    std::vector<uint8_t> global_ops = generate_random_bits(TOTAL_OPERATIONS, ratio);
-    // 预填充 避免空队列卡死
-    if (ratio == 0.3)
-        shuffle_queue(queue, TOTAL_OPERATIONS * 0.5);
-    else if (ratio == 0.5)
-        shuffle_queue(queue, TOTAL_OPERATIONS * 0.3);
-    else
-        shuffle_queue(queue, TOTAL_OPERATIONS * 0.1);
+static void report_mixed_queues(std::ofstream &ofs, const Workload &w) {
+    report_mixed<BlockingQueue<int>>(ofs, "BLOCKING_QUEUE", "BLOCKING", w);
+    report_mixed<NonBlockingQueue<int>>(ofs, "NONBLOCKING_QUEUE", "NONBLOCKING", w);
+    // sleeping on an eventcount when full/empty
+    report_mixed<NonBlockingQueue<int, nbq_layout<>, eventcount_wait>>(ofs, "NONBLOCKING_QUEUE_EC", "NONBLOCKING_EC", w);
+    report_mixed<TBBQueue<int>>(ofs, "TBB_QUEUE", "TBB", w);
+    report_mixed<TBBQueue<int, eventcount_wait>>(ofs, "TBB_QUEUE_EC", "TBB_EC", w);
+    // unbounded
+    report_mixed<MSQueue<int>>(ofs, "MS_QUEUE", "MS", w);
+    // fetch-and-add on linked ring segments
+    report_mixed<FAAQueue<int>>(ofs, "FAA_QUEUE", "FAA", w);
+    // one combiner thread applies everyone's requests
+    report_mixed<FlatCombiningQueue<int>>(ofs, "FC_QUEUE", "FC", w);
+}
 
-    size_t ops_per_thread = TOTAL_OPERATIONS / threads;
-    std::vector<std::vector<int>> per_thread_values(threads);
-    for (size_t t = 0; t < threads; ++t) {
-        per_thread_values[t].resize(ops_per_thread);
-        std::iota(per_thread_values[t].begin(), per_thread_values[t].end(), static_cast<int>(t * 100000));
+static int run_mixed_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
     }
 
-    std::atomic<int> ready_count{0};
-    std::atomic<bool> start_flag{false};
-    std::atomic<bool> fatal_error{false};
-    std::vector<std::thread> workers;
-    workers.reserve(threads);
-
-    auto worker_fn = [&](size_t tid){
-        try {
-            // signal ready
-            ready_count.fetch_add(1, std::memory_order_release);
+    write_mixed_header(ofs);
 
-            while (!start_flag.load(std::memory_order_acquire)) {
-                if (fatal_error.load(std::memory_order_acquire)) return;
-                std::this_thread::sleep_for(std::chrono::microseconds(50));
-            }
+    for (auto ratio : workload_ratios()) {
+        std::cout << "Benchmarking with ratio=" << ratio << " ... \n";
 
-            for (size_t i = 0; i < ops_per_thread; ++i) {
-                uint8_t op = global_ops[tid * ops_per_thread + i];
-                if (op == 1) { // enqueue
-                    queue.add(per_thread_values[tid][i]);
-                } else { // dequeue
-                    int val = queue.remove();
-                    (void)val; // 防止未使用警告
-                }
+        for (int threads : THREAD_COUNTS) {
+            std::cout << "Running with threads=" << threads << " ... " << std::flush;
+            try {
+                // one op sequence per point, the same for every queue
+                report_mixed_queues(ofs, mixed_workload(threads, ratio));
+                std::cout << "\n";
+            } catch (const std::exception& e) {
+                std::cerr << "\nBenchmark for threads=" << threads << " aborted: " << e.what() << "\n";
+                // on error, abort further benchmarking
+                return 2;
+            } catch (...) {
+                std::cerr << "\nUnknown exception during benchmark for threads=" << threads << "\n";
+                return 3;
             }
-        } catch (const std::exception& e) {
-            std::cerr << "Thread " << tid << " exception: " << e.what() << "\n";
-            fatal_error.store(true);
-            throw;
-        } catch (...) {
-            std::cerr << "Thread " << tid << " unknown exception\n";
-            fatal_error.store(true);
-            throw;
         }
-    };
+    }
 
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    std::cout << "Use plot_results.py to generate graphs from the CSV.\n";
 
-    for (size_t t = 0; t < threads; ++t) {
-        workers.emplace_back(worker_fn, t);
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
-    }
+    return 0;
+}
 
-    const auto wait_start_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
-    while (ready_count.load(std::memory_order_acquire) != static_cast<int>(threads)) {
-        if (fatal_error.load(std::memory_order_acquire)) {
-            for (auto &th : workers) if (th.joinable()) th.join();
-            throw std::runtime_error("Fatal error occurred before start");
-        }
-        if (std::chrono::steady_clock::now() > wait_start_deadline) {
-            std::cerr << "Timeout waiting for threads to become ready (ready=" << ready_count.load() << ", expected=" << threads << ")\n";
-            for (auto &th : workers) if (th.joinable()) th.join();
-            throw std::runtime_error("Timeout waiting for threads to become ready");
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
+// NonBlockingQueue under every nbq_layout combination, all at 32 threads.
+// Bit 0 pads head/tail, bit 1 pads slots, bit 2 masks the index,
+// bit 3 fixes the capacity at compile time.
+const int LAYOUT_THREADS = 32;
 
-    // start 
-    start_flag.store(true, std::memory_order_release);
-    auto t0 = std::chrono::high_resolution_clock::now();
+template<unsigned Bits>
+using layout_queue = NonBlockingQueue<int, nbq_layout<(Bits & 1) != 0, (Bits & 2) != 0, (Bits & 4) != 0,
+                                                      (Bits & 8) ? QUEUE_CAPACITY : 0>>;
 
-    for (auto &th : workers) {
-        if (th.joinable()) {
-            th.join();
-        }
+template<unsigned Bits>
+static void run_layout(std::ofstream &ofs, const Workload &w) {
+    double t = run_benchmark_queue<layout_queue<Bits>>(w);
+    ofs << "NONBLOCKING_QUEUE," << LAYOUT_THREADS << "," << std::defaultfloat << w.ratio << ","
+        << ((Bits & 1) != 0) << "," << ((Bits & 2) != 0) << "," << ((Bits & 4) != 0) << ","
+        << ((Bits & 8) != 0) << "," << std::fixed << std::setprecision(6) << t << "\n";
+    ofs.flush();
+    std::cout << "layout" << Bits << "=" << t << "s " << std::flush;
+    if constexpr (Bits + 1 < 16) run_layout<Bits + 1>(ofs, w);
+}
+
+static int run_layout_mode(const std::string &out_csv) {
+    std::ofstream ofs(out_csv);
+    if (!ofs) {
+        std::cerr << "Cannot open " << out_csv << " for writing\n";
+        return 1;
     }
-    auto t1 = std::chrono::high_resolution_clock::now();
+    ofs << "queue,threads,ratio,pad_indices,pad_slots,mask_index,static_capacity,seconds\n";
 
-    if (fatal_error.load(std::memory_order_acquire)) {
-        throw std::runtime_error("Fatal error occurred in one of the worker threads");
+    for (auto ratio : workload_ratios()) {
+        std::cout << "Benchmarking layouts with ratio=" << ratio << " ... \n";
+        try {
+            run_layout<0>(ofs, mixed_workload(LAYOUT_THREADS, ratio));
+        } catch (const std::exception& e) {
+            std::cerr << "\nLayout benchmark aborted: " << e.what() << "\n";
+            return 2;
+        }
+        std::cout << "\n";
     }
 
-    std::chrono::duration<double> dur = t1 - t0;
-    return dur.count();
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
 }
 
-int main(int argc, char** argv) {
-    std::string out_csv = "benchmark_results.csv";
-    if (argc >= 2) out_csv = argv[1];
+// The mixed queues on one recorded workload: replayed from --replay=FILE,
+// or generated from --threads/--ratio/--workload/--seed and, with
+// --record=FILE, saved for later replays.
+static int run_trace_mode(const std::string &out_csv) {
+    const WorkloadConfig &cfg = workload_config();
+    Workload w;
+    std::string err;
+    if (!cfg.replay.empty()) {
+        if (!load_trace(cfg.replay, QUEUE_CAPACITY, MIXED_MAX_THREADS, w, err)) {
+            std::cerr << "Cannot replay trace: " << err << "\n";
+            return 1;
+        }
+    } else {
+        if (cfg.threads < 1 || (size_t)cfg.threads > MIXED_MAX_THREADS) {
+            std::cerr << "Cannot generate trace: --threads must be between 1 and " << MIXED_MAX_THREADS << "\n";
+            return 1;
+        }
+        try {
+            w = mixed_workload(cfg.threads, cfg.ratio);
+        } catch (const std::invalid_argument &e) {
+            std::cerr << "Cannot generate trace: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (!cfg.record.empty() && !save_trace(cfg.record, w, err)) {
+        std::cerr << "Cannot record trace: " << err << "\n";
+        return 1;
+    }
 
     std::ofstream ofs(out_csv);
     if (!ofs) {
         std::cerr << "Cannot open " << out_csv << " for writing\n";
         return 1;
     }
+    write_mixed_header(ofs);
 
-    ofs << "queue,threads,ratio,seconds\n";
+    std::cout << "Trace: " << w.threads() << " threads, " << w.total() << " ops, " << workload_name(w.kind)
+              << ", seed " << w.seed << ", add fraction " << std::setprecision(3) << w.add_fraction() << ", prefill "
+              << w.prefill << "\n" << std::flush;
+    report_mixed_queues(ofs, w);
+    std::cout << "\n";
 
-    for (auto ratio : RATIO) {
-        //ofs << "# Ratio=" << ratio << "\n";
-        std::cout << "Benchmarking with ratio=" << ratio << " ... \n";
+    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
+    return 0;
+}
 
-        for (int threads : THREAD_COUNTS) {
-            std::cout << "Running with threads=" << threads << " ... " << std::flush;
-            try {
-                    // BLOCKING_QUEUE
-                    {
-                        double t = run_benchmark_queue<BlockingQueue<int>>(threads, ratio);
-                        ofs << "BLOCKING_QUEUE," << threads << ","  << ratio << "," << std::fixed << std::setprecision(6) << t << "\n";
-                        ofs.flush();
-                        std::cout << "BLOCKING=" << t << "s ";
-                    }
-
-                    // NONBLOCKING_QUEUE
-                    {
-                        double t = run_benchmark_queue<NonBlockingQueue<int>>(threads, ratio);
-                        ofs << "NONBLOCKING_QUEUE," << threads << ","  << ratio << "," << std::fixed << std::setprecision(6) << t << "\n";
-                        ofs.flush();
-                        std::cout << "NONBLOCKING=" << t << "s ";
-                    }
-
-                    // TBB
-                    {
-                        double t = run_benchmark_queue<TBBQueue<int>>(threads, ratio);
-                        ofs << "TBB_QUEUE," << threads << ","  << ratio << "," << std::fixed << std::setprecision(6) << t << "\n";
-                        ofs.flush();
-                        std::cout << "TBB=" << t << "s";
-                    }
-
-                    std::cout << "\n";
-                } catch (const std::exception& e) {
-                    std::cerr << "\nBenchmark for threads=" << threads << " aborted: " << e.what() << "\n";
-                    // on error, abort further benchmarking
-                    return 2;
-                } catch (...) {
-                    std::cerr << "\nUnknown exception during benchmark for threads=" << threads<< "\n";
-                    return 3;
-                }
+// usage: benchmark [output.csv]
+//                  [--mode=mixed|batch|layout|idle|role|pc|latency|payload|try|timeout|pool|pq|shm|storage|trace]
+//                  [--warmup=N] [--reps=N] [--pin=none|compact|scatter]
+//                  [--workload=random|bursty|patterned] [--seed=N]
+//                  [--threads=N] [--ratio=R] [--record=FILE] [--replay=FILE]   (trace mode)
+int main(int argc, char** argv) {
+    std::string mode = "mixed";
+    std::string out_csv;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--mode=", 0) == 0) {
+            mode = arg.substr(7);
+        } else if (arg.rfind("--warmup=", 0) == 0) {
+            runner_config().warmup = atoi(arg.c_str() + 9);
+        } else if (arg.rfind("--reps=", 0) == 0) {
+            runner_config().repetitions = atoi(arg.c_str() + 7);
+        } else if (arg.rfind("--pin=", 0) == 0) {
+            if (!parse_pin(arg.substr(6), runner_config().pin)) {
+                std::cerr << "Unknown pin policy " << arg.substr(6) << "\n";
+                return 1;
+            }
+        } else if (arg.rfind("--workload=", 0) == 0) {
+            if (!parse_workload(arg.substr(11), workload_config().kind)) {
+                std::cerr << "Unknown workload " << arg.substr(11) << "\n";
+                return 1;
+            }
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            workload_config().seed = strtoull(arg.c_str() + 7, nullptr, 0);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            workload_config().threads = atoi(arg.c_str() + 10);
+        } else if (arg.rfind("--ratio=", 0) == 0) {
+            workload_config().ratio = atof(arg.c_str() + 8);
+        } else if (arg.rfind("--record=", 0) == 0) {
+            workload_config().record = arg.substr(9);
+        } else if (arg.rfind("--replay=", 0) == 0) {
+            workload_config().replay = arg.substr(9);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        } else {
+            out_csv = arg;
         }
     }
 
-    std::cout << "Benchmark finished. Results written to " << out_csv << "\n";
-    std::cout << "Use plot_results.py to generate graphs from the CSV.\n";
-
-    return 0;
+    if (mode == "mixed") {
+        return run_mixed_mode(out_csv.empty() ? "benchmark_results.csv" : out_csv);
+    } else if (mode == "batch") {
+        return run_batch_mode(out_csv.empty() ? "batch_results.csv" : out_csv);
+    } else if (mode == "layout") {
+        return run_layout_mode(out_csv.empty() ? "layout_results.csv" : out_csv);
+    } else if (mode == "idle") {
+        return run_idle_mode(out_csv.empty() ? "idle_results.csv" : out_csv);
+    } else if (mode == "role") {
+        return run_role_mode(out_csv.empty() ? "role_results.csv" : out_csv);
+    } else if (mode == "pc") {
+        return run_pc_mode(out_csv.empty() ? "pc_results.csv" : out_csv);
+    } else if (mode == "latency") {
+        return run_latency_mode(out_csv.empty() ? "latency_results.csv" : out_csv);
+    } else if (mode == "payload") {
+        return run_payload_mode(out_csv.empty() ? "payload_results.csv" : out_csv);
+    } else if (mode == "try") {
+        return run_try_mode(out_csv.empty() ? "try_results.csv" : out_csv);
+    } else if (mode == "timeout") {
+        return run_timeout_mode(out_csv.empty() ? "timeout_results.csv" : out_csv);
+    } else if (mode == "pool") {
+        return run_pool_mode(out_csv.empty() ? "pool_results.csv" : out_csv);
+    } else if (mode == "pq") {
+        return run_pq_mode(out_csv.empty() ? "pq_results.csv" : out_csv);
+    } else if (mode == "shm") {
+        return run_shm_mode(out_csv.empty() ? "shm_results.csv" : out_csv);
+    } else if (mode == "storage") {
+        return run_storage_mode(out_csv.empty() ? "storage_results.csv" : out_csv);
+    } else if (mode == "trace") {
+        return run_trace_mode(out_csv.empty() ? "trace_results.csv" : out_csv);
+    }
+    std::cerr << "Unknown mode " << mode << "\n";
+    return 1;
 }
\ No newline at end of file
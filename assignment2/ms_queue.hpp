@@ -0,0 +1,187 @@
+#ifndef MS_QUEUE_HPP
+#define MS_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <chrono>
+
+#include "ebr.hpp"
+#include "eventcount.hpp"
+#include "slot_storage.hpp"
+#include "queue_stats.hpp"
+#include "queue_ops.hpp"
+
+// Unbounded lock-free MPMC queue (Michael & Scott, PODC '96).
+//
+// head points at a dummy node whose successor holds the front item. Nodes
+// are unlinked by the dequeuer that moves head past them and freed through
+// ebr::retire(); freed nodes go to a per-thread freelist that add() takes
+// from before falling back to new.
+template <typename T, typename Wait = spin_wait>
+class MSQueue : public unbounded_add<MSQueue<T, Wait>, T> {
+private:
+    // the dummy node's data is empty, every node after it holds a value
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        RawSlot<T> data;
+    };
+
+    static const size_t FREELIST_MAX = 4096;   // nodes kept per thread
+
+    struct Freelist {
+        std::vector<Node *> nodes;
+        ~Freelist() {
+            for (Node *n : nodes) delete n;
+        }
+    };
+
+    static Freelist &freelist() {
+        static thread_local Freelist fl;
+        return fl;
+    }
+
+    static Node *alloc_node() {
+        Freelist &fl = freelist();
+        if (fl.nodes.empty()) return new Node;
+        Node *n = fl.nodes.back();
+        fl.nodes.pop_back();
+        n->next.store(nullptr, std::memory_order_relaxed);
+        return n;
+    }
+
+    static void free_node(void *p) {
+        Freelist &fl = freelist();
+        if (fl.nodes.size() < FREELIST_MAX) {
+            fl.nodes.push_back(static_cast<Node *>(p));
+        } else {
+            delete static_cast<Node *>(p);
+        }
+    }
+
+    alignas(64) std::atomic<Node *> head;
+    alignas(64) std::atomic<Node *> tail;
+    alignas(64) Wait not_empty;
+    StatCounters<> counters;
+
+    // Move head past the current dummy and retire it. On success `next` is
+    // the new dummy, whose value now belongs to the caller. Call inside a
+    // guard, and take the value before leaving it.
+    bool unlink_front(Node *&next) {
+        while (true) {
+            Node *h = head.load(std::memory_order_acquire);
+            Node *t = tail.load(std::memory_order_acquire);
+            next = h->next.load(std::memory_order_acquire);
+            if (h != head.load(std::memory_order_acquire)) {
+                counters.add(stat_retry);
+                continue;
+            }
+            if (h == t) {
+                if (next == nullptr) return false;
+                // tail is lagging
+                counters.add(stat_retry);
+                tail.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+            } else if (head.compare_exchange_weak(h, next, std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed)) {
+                ebr::retire(h, &MSQueue::free_node);
+                return true;
+            } else {
+                counters.add(stat_head_cas_fail);
+            }
+        }
+    }
+
+public:
+    typedef T value_type;
+
+    explicit MSQueue(size_t) {
+        Node *dummy = new Node;
+        head.store(dummy, std::memory_order_relaxed);
+        tail.store(dummy, std::memory_order_relaxed);
+    }
+
+    ~MSQueue() {
+        Node *n = head.load(std::memory_order_relaxed);
+        bool dummy = true;
+        while (n) {
+            Node *next = n->next.load(std::memory_order_relaxed);
+            if (!dummy) n->data.destroy();
+            delete n;
+            n = next;
+            dummy = false;
+        }
+    }
+
+    MSQueue(const MSQueue &) = delete;
+    MSQueue &operator=(const MSQueue &) = delete;
+
+    QueueStats stats() const { return counters.merged(); }
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        Node *node = alloc_node();
+        node->data.emplace(std::forward<Args>(args)...);
+
+        ebr::Guard guard;
+        while (true) {
+            Node *t = tail.load(std::memory_order_acquire);
+            Node *next = t->next.load(std::memory_order_acquire);
+            if (t != tail.load(std::memory_order_acquire)) {
+                counters.add(stat_retry);
+                continue;
+            }
+            if (next == nullptr) {
+                if (t->next.compare_exchange_weak(next, node, std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+                    // swing tail; someone else may already have
+                    tail.compare_exchange_strong(t, node, std::memory_order_release,
+                                                 std::memory_order_relaxed);
+                    break;
+                }
+                counters.add(stat_tail_cas_fail);
+            } else {
+                // tail is lagging, help it along
+                counters.add(stat_retry);
+                tail.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+            }
+        }
+        not_empty.notify_one();
+    }
+
+    bool try_remove(T &out) {
+        ebr::Guard guard;
+        Node *next;
+        if (!unlink_front(next)) return false;
+        out = next->data.take();
+        return true;
+    }
+
+    T remove() {
+        while (true) {
+            {
+                ebr::Guard guard;
+                Node *next;
+                if (unlink_front(next)) return next->data.take();
+            }
+            counters.empty_wait(not_empty.await([this]() { return !empty(); }));
+        }
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        return retry_until(not_empty, std::chrono::steady_clock::now() + timeout, [&]() { return try_remove(out); },
+                           [this]() { return !empty(); }, [this](bool gave_up) { counters.empty_wait(gave_up); });
+    }
+
+    bool empty() const {
+        ebr::Guard guard;
+        return head.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // MS_QUEUE_HPP
@@ -0,0 +1,161 @@
+#ifndef MULTI_QUEUE_HPP
+#define MULTI_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "random_bits.hpp"
+
+// Relaxed concurrent priority queue (Rihani, Sanders & Dementiev,
+// "MultiQueues", SPAA '15). Smallest key first, e.g. a deadline.
+//
+// c * threads sequential binary heaps, each behind a try-lock. add() puts
+// the item into a random heap that it can lock. try_remove() looks at the
+// tops of two random heaps and pops the smaller one, so it returns one of
+// the smallest keys rather than the smallest: the expected rank error is
+// O(number of heaps).
+//
+// Each heap publishes its top key in an atomic, so choosing between two
+// heaps takes no lock, and an empty heap publishes UINT64_MAX, so keys go
+// up to MAX_KEY only. try_remove() returns false only after seeing every
+// heap empty.
+template <typename T>
+class MultiQueue {
+public:
+    static constexpr uint64_t MAX_KEY = UINT64_MAX - 1;
+
+private:
+    static constexpr uint64_t NO_KEY = UINT64_MAX;
+
+    struct Entry {
+        uint64_t key;
+        T value;
+    };
+
+    // std::*_heap build a max-heap, so order by greater key
+    struct later {
+        bool operator()(const Entry &a, const Entry &b) const { return a.key > b.key; }
+    };
+
+    struct alignas(64) Heap {
+        std::atomic<bool> locked{false};
+        std::atomic<uint64_t> top{NO_KEY};
+        std::vector<Entry> items;
+
+        bool try_lock() {
+            return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+        }
+        void unlock() { locked.store(false, std::memory_order_release); }
+        void publish_top() {
+            top.store(items.empty() ? NO_KEY : items.front().key, std::memory_order_relaxed);
+        }
+    };
+
+    size_t n;
+    std::unique_ptr<Heap[]> heaps;
+
+    static uint64_t next_random() {
+        static thread_local uint64_t x = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+        return xorshift64(x);
+    }
+
+    bool all_empty() const {
+        for (size_t i = 0; i < n; ++i) {
+            if (heaps[i].top.load(std::memory_order_relaxed) != NO_KEY) return false;
+        }
+        return true;
+    }
+
+public:
+    typedef T value_type;
+
+    explicit MultiQueue(size_t threads, size_t c = 2)
+        : n(std::max<size_t>(2, threads * c)), heaps(new Heap[n]) {}
+
+    MultiQueue(const MultiQueue &) = delete;
+    MultiQueue &operator=(const MultiQueue &) = delete;
+
+    size_t heap_count() const { return n; }
+
+    void add(uint64_t key, T value) {
+        assert(key <= MAX_KEY);
+        while (true) {
+            Heap &h = heaps[next_random() % n];
+            if (!h.try_lock()) continue;
+            h.items.push_back(Entry{key, std::move(value)});
+            std::push_heap(h.items.begin(), h.items.end(), later());
+            h.publish_top();
+            h.unlock();
+            return;
+        }
+    }
+
+    bool try_remove(uint64_t &key, T &out) {
+        while (true) {
+            uint64_t r = next_random();
+            Heap *a = &heaps[r % n];
+            Heap *b = &heaps[(r >> 32) % n];
+            if (b->top.load(std::memory_order_relaxed) < a->top.load(std::memory_order_relaxed)) std::swap(a, b);
+            if (a->top.load(std::memory_order_relaxed) == NO_KEY) {
+                if (all_empty()) return false;
+                continue;
+            }
+            if (!a->try_lock()) continue;
+            if (a->items.empty()) {
+                // emptied since we looked
+                a->unlock();
+                continue;
+            }
+            std::pop_heap(a->items.begin(), a->items.end(), later());
+            key = a->items.back().key;
+            out = std::move(a->items.back().value);
+            a->items.pop_back();
+            a->publish_top();
+            a->unlock();
+            return true;
+        }
+    }
+};
+
+// Exact baseline: one std::priority_queue behind one mutex.
+template <typename T>
+class LockedPriorityQueue {
+private:
+    typedef std::pair<uint64_t, T> Entry;
+
+    std::mutex lock;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+
+public:
+    typedef T value_type;
+
+    explicit LockedPriorityQueue(size_t) {}
+
+    void add(uint64_t key, T value) {
+        std::lock_guard<std::mutex> guard(lock);
+        pq.emplace(key, std::move(value));
+    }
+
+    bool try_remove(uint64_t &key, T &out) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (pq.empty()) return false;
+        key = pq.top().first;
+        out = std::move(const_cast<Entry &>(pq.top()).second);
+        pq.pop();
+        return true;
+    }
+};
+
+#endif // MULTI_QUEUE_HPP
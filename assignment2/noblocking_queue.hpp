@@ -4,86 +4,290 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <atomic>
+#include <algorithm>
 #include <stdexcept>
 #include <cstdint>
 #include <cassert>
 #include <thread>
 #include <chrono>
+#include <utility>
+#include <type_traits>
 
-template <typename T>
-class NonBlockingQueue {
+#include "eventcount.hpp"
+#include "slot_storage.hpp"
+#include "queue_stats.hpp"
+#include "queue_ops.hpp"
+#include "seq_ring.hpp"
+
+// Memory layout knobs for NonBlockingQueue.
+//   PadIndices      put head and tail on separate cache lines
+//   PadSlots        give every slot its own cache line
+//   MaskIndex       round capacity up to a power of two, index with & mask
+//   StaticCapacity  fix the capacity at compile time (0 = constructor arg);
+//                   a constructor arg larger than it throws
+// The default is the original layout: everything packed, index % capacity.
+template <bool PadIndices = false, bool PadSlots = false, bool MaskIndex = false,
+          size_t StaticCapacity = 0>
+struct nbq_layout {
+    static constexpr bool pad_indices = PadIndices;
+    static constexpr bool pad_slots = PadSlots;
+    static constexpr bool mask_index = MaskIndex;
+    static constexpr size_t static_capacity = StaticCapacity;
+
+    static_assert(!MaskIndex || StaticCapacity == 0 || (StaticCapacity & (StaticCapacity - 1)) == 0,
+                  "mask indexing needs a power-of-two capacity");
+};
+
+// The ring itself is SeqRing (seq_ring.hpp); this class lays it out in
+// process memory. Wait is what a thread does on a full or empty queue:
+// spin_wait (the default) backs off and yields, eventcount_wait sleeps on
+// a futex and is woken by the opposite side. See eventcount.hpp. Alloc
+// provides the slot array, e.g. ring_allocator from ring_storage.hpp.
+template <typename T, typename Layout = nbq_layout<>, typename Wait = spin_wait,
+          typename Alloc = std::allocator<T>>
+class NonBlockingQueue : public SeqRing<NonBlockingQueue<T, Layout, Wait, Alloc>, T, size_t> {
 private:
-    struct Node {
+    typedef SeqRing<NonBlockingQueue, T, size_t> Ring;
+    friend Ring;
+
+    using Ring::can_add;
+    using Ring::can_remove;
+    using Ring::claim_back;
+    using Ring::claim_front;
+
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr size_t SLOT_ALIGN = Layout::pad_slots ? CACHE_LINE : 1;
+    static constexpr size_t INDEX_ALIGN = Layout::pad_indices ? CACHE_LINE : 1;
+
+    struct alignas(std::atomic<size_t>) alignas(T) alignas(SLOT_ALIGN) Node {
         std::atomic<size_t> seq;
-        T data;
+        RawSlot<T> data;
     };
 
-    size_t capacity;
-    std::vector<Node> buffer;
-    std::atomic<size_t> head;
-    std::atomic<size_t> tail;
-
-    // 退避 让步
-    void backoff() {
-        static thread_local int spins = 0;
-        if (++spins < 16) {
-            for (volatile int i = 0; i < 30; ++i) {
-                asm volatile("":::"memory");
+    size_t capacity;   // runtime copies; cap() and index_mask() use the
+    size_t mask;       // compile-time values when there are any
+    std::vector<Node, typename std::allocator_traits<Alloc>::template rebind_alloc<Node>> buffer;
+    alignas(std::atomic<size_t>) alignas(INDEX_ALIGN) std::atomic<size_t> head;
+    alignas(std::atomic<size_t>) alignas(INDEX_ALIGN) std::atomic<size_t> tail;
+    alignas(INDEX_ALIGN) Wait not_full;
+    alignas(INDEX_ALIGN) Wait not_empty;
+    StatCounters<> counters;
+
+    size_t cap() const {
+        return Layout::static_capacity ? Layout::static_capacity : capacity;
+    }
+
+    size_t index_mask() const {
+        return Layout::static_capacity ? Layout::static_capacity - 1 : mask;
+    }
+
+    size_t slot(size_t pos) const {
+        return Layout::mask_index ? (pos & index_mask()) : (pos % cap());
+    }
+
+    static size_t round_capacity(size_t n) {
+        if (Layout::static_capacity) {
+            if (n > Layout::static_capacity) {
+                throw std::invalid_argument("NonBlockingQueue: capacity exceeds the layout's static capacity");
             }
-        } else {
-            std::this_thread::yield();
-            if (spins > 1024) spins = 0;
+            return Layout::static_capacity;
         }
+        if (!Layout::mask_index) return n;
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // SeqRing storage
+    std::atomic<size_t> &ring_head() { return head; }
+    std::atomic<size_t> &ring_tail() { return tail; }
+    Node &ring_node(size_t pos) { return buffer[slot(pos)]; }
+    size_t ring_capacity() const { return cap(); }
+    void ring_count(queue_stat s) { counters.add(s); }
+
+    bool claim_back_until(size_t &pos, std::chrono::steady_clock::time_point deadline) {
+        return retry_until(not_full, deadline, [&]() { return claim_back(pos); }, [this]() { return can_add(); },
+                           [this](bool gave_up) { counters.full_wait(gave_up); });
+    }
+
+    bool claim_front_until(size_t &pos, std::chrono::steady_clock::time_point deadline) {
+        return retry_until(not_empty, deadline, [&]() { return claim_front(pos); }, [this]() { return can_remove(); },
+                           [this](bool gave_up) { counters.empty_wait(gave_up); });
+    }
+
+    template <typename... Args>
+    void fill(size_t pos, Args &&...args) {
+        this->publish(pos, std::forward<Args>(args)...);
+        not_empty.notify_one();
+    }
+
+    T drain(size_t pos) {
+        T out = this->release(pos);
+        not_full.notify_one();
+        return out;
     }
 
 public:
+    typedef T value_type;
+
     explicit NonBlockingQueue(size_t capacity)
-        : capacity(capacity), buffer(capacity), head(0), tail(0) {
-        
-        for (size_t i = 0; i < capacity; ++i) {
+        : capacity(round_capacity(capacity)), mask(this->capacity - 1),
+          buffer(this->capacity), head(0), tail(0) {
+
+        for (size_t i = 0; i < this->capacity; ++i) {
             buffer[i].seq.store(i, std::memory_order_relaxed);
         }
     }
 
-    void add(const T &item) {
+    ~NonBlockingQueue() {
+        if (std::is_trivially_destructible<T>::value) return;
+        size_t t = tail.load(std::memory_order_relaxed);
+        for (size_t pos = head.load(std::memory_order_relaxed); pos != t; ++pos) {
+            buffer[slot(pos)].data.destroy();
+        }
+    }
+
+    NonBlockingQueue(const NonBlockingQueue &) = delete;
+    NonBlockingQueue &operator=(const NonBlockingQueue &) = delete;
+
+    QueueStats stats() const { return counters.merged(); }
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    // construct the item directly in its slot
+    template <typename... Args>
+    void emplace(Args &&...args) {
         size_t pos;
-        while (true) {
-            pos = tail.load(std::memory_order_relaxed);
-            Node &node = buffer[pos % capacity];
-            size_t seq = node.seq.load(std::memory_order_acquire);
-            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
-
-            if (dif == 0) {
-                if (tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
-                    node.data = item;
-                    node.seq.store(pos + 1, std::memory_order_release);
-                    return;
-                }
-            } else if (dif < 0) {
-                // full
-                backoff();
-            } else {}
+        while (!claim_back(pos)) {
+            // full
+            counters.full_wait(not_full.await([this]() { return can_add(); }));
         }
+        fill(pos, std::forward<Args>(args)...);
     }
 
     T remove() {
         size_t pos;
-        while (true) {
-            pos = head.load(std::memory_order_relaxed);
-            Node &node = buffer[pos % capacity];
-            size_t seq = node.seq.load(std::memory_order_acquire);
-            intptr_t dif = (intptr_t)seq - (intptr_t)(pos+1);
-            if (dif == 0) {
-                if (head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
-                    T out = node.data;
-                    node.seq.store(pos + capacity, std::memory_order_release);
-                    return out;
+        while (!claim_front(pos)) {
+            // empty
+            counters.empty_wait(not_empty.await([this]() { return can_remove(); }));
+        }
+        return drain(pos);
+    }
+
+    // Single attempt: false at once if the queue is full / empty.
+    bool try_add(const T &item) { return try_emplace(item); }
+    bool try_add(T &&item) { return try_emplace(std::move(item)); }
+
+    template <typename... Args>
+    bool try_emplace(Args &&...args) {
+        size_t pos;
+        if (!claim_back(pos)) return false;
+        fill(pos, std::forward<Args>(args)...);
+        return true;
+    }
+
+    bool try_remove(T &out) {
+        size_t pos;
+        if (!claim_front(pos)) return false;
+        out = drain(pos);
+        return true;
+    }
+
+    // Wait up to timeout for room / an item.
+    template <typename Rep, typename Period>
+    bool try_add_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        size_t pos;
+        if (!claim_back_until(pos, std::chrono::steady_clock::now() + timeout)) return false;
+        fill(pos, item);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(T &&item, const std::chrono::duration<Rep, Period> &timeout) {
+        size_t pos;
+        if (!claim_back_until(pos, std::chrono::steady_clock::now() + timeout)) return false;
+        fill(pos, std::move(item));
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        size_t pos;
+        if (!claim_front_until(pos, std::chrono::steady_clock::now() + timeout)) return false;
+        out = drain(pos);
+        return true;
+    }
+
+    // Enqueue n items, claiming as many free slots as possible with a single
+    // CAS on tail and then filling them in order. A slot of the claimed run
+    // can still be read by a slow consumer from the previous lap, so each
+    // slot is written only once its seq says it is free.
+    void add_bulk(const T *items, size_t n) {
+        while (n > 0) {
+            size_t pos = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            intptr_t used = (intptr_t)pos - (intptr_t)h;
+            if (used < 0) {
+                // tail moved on while we read head
+                counters.add(stat_retry);
+                continue;
+            }
+            if (used >= (intptr_t)cap()) {
+                // full
+                counters.full_wait(not_full.await([this]() { return can_add(); }));
+                continue;
+            }
+            size_t k = std::min(n, cap() - (size_t)used);
+            if (!tail.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                counters.add(stat_tail_cas_fail);
+                continue;
+            }
+            for (size_t i = 0; i < k; ++i) {
+                Node &node = buffer[slot(pos + i)];
+                while (node.seq.load(std::memory_order_acquire) != pos + i) {
+                    // a consumer from the last lap is still in this slot
+                    counters.full_wait(spin_backoff());
                 }
-            } else if (dif < 0) {
+                node.data.emplace(items[i]);
+                node.seq.store(pos + i + 1, std::memory_order_release);
+            }
+            not_empty.notify_all();
+            items += k;
+            n -= k;
+        }
+    }
+
+    // Dequeue between 1 and max items into out, claiming them with a single
+    // CAS on head; blocks while the queue is empty. Returns the count.
+    size_t remove_bulk(T *out, size_t max) {
+        while (true) {
+            size_t pos = head.load(std::memory_order_relaxed);
+            size_t t = tail.load(std::memory_order_acquire);
+            intptr_t avail = (intptr_t)t - (intptr_t)pos;
+            if (avail <= 0) {
                 // empty
-                backoff();
-            } else {}
+                counters.empty_wait(not_empty.await([this]() { return can_remove(); }));
+                continue;
+            }
+            size_t k = std::min(max, (size_t)avail);
+            if (!head.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                counters.add(stat_head_cas_fail);
+                continue;
+            }
+            // claimed slots may still be being filled by their producers
+            for (size_t i = 0; i < k; ++i) {
+                Node &node = buffer[slot(pos + i)];
+                while (node.seq.load(std::memory_order_acquire) != pos + i + 1) {
+                    counters.empty_wait(spin_backoff());
+                }
+                out[i] = node.data.take();
+                node.seq.store(pos + i + cap(), std::memory_order_release);
+            }
+            not_full.notify_all();
+            return k;
         }
     }
 };
@@ -21,7 +21,11 @@ for r in ratios:
     plt.figure()
     for q in queues:
         qdf = df[(df['queue'] == q) & (df['ratio'] == r)].sort_values('threads')
-        plt.plot(qdf['threads'], qdf['seconds'], marker='o', label=q)
+        if 'seconds_ci_low' in qdf:
+            err = [qdf['seconds'] - qdf['seconds_ci_low'], qdf['seconds_ci_high'] - qdf['seconds']]
+            plt.errorbar(qdf['threads'], qdf['seconds'], yerr=err, marker='o', capsize=2, label=q)
+        else:
+            plt.plot(qdf['threads'], qdf['seconds'], marker='o', label=q)
     plt.xlabel('Threads')
     plt.ylabel('Seconds')
     plt.title(f'Ratio={r}')
@@ -0,0 +1,46 @@
+#ifndef QUEUE_OPS_HPP
+#define QUEUE_OPS_HPP
+
+#pragma once
+
+#include <chrono>
+#include <utility>
+
+// Pieces of the try/timed operations that the queues share.
+
+// Retry try_op() until it succeeds or deadline passes, waiting on `wait`
+// for ready() in between. on_wait(gave_up) runs after every wait, with
+// what the Wait policy's await_until returned.
+template <typename Wait, typename TryOp, typename Ready, typename OnWait>
+static inline bool retry_until(Wait &wait, std::chrono::steady_clock::time_point deadline, TryOp try_op,
+                               Ready ready, OnWait on_wait) {
+    while (!try_op()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        on_wait(wait.await_until(ready, deadline));
+    }
+    return true;
+}
+
+// try_add, try_emplace and try_add_for of an unbounded queue (CRTP base):
+// adding never fails or waits, so they all go straight to Derived::emplace
+// and the timeout is only taken to keep the interface the same.
+template <typename Derived, typename T>
+class unbounded_add {
+public:
+    bool try_add(const T &item) { return try_emplace(item); }
+    bool try_add(T &&item) { return try_emplace(std::move(item)); }
+
+    template <typename... Args>
+    bool try_emplace(Args &&...args) {
+        static_cast<Derived &>(*this).emplace(std::forward<Args>(args)...);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(const T &item, const std::chrono::duration<Rep, Period> &) { return try_emplace(item); }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(T &&item, const std::chrono::duration<Rep, Period> &) { return try_emplace(std::move(item)); }
+};
+
+#endif // QUEUE_OPS_HPP
@@ -0,0 +1,108 @@
+#ifndef QUEUE_STATS_HPP
+#define QUEUE_STATS_HPP
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Internal event counters for the queues, compiled in with
+// -DQUEUE_STATS=1 (make STATS=1); otherwise StatCounters is empty and
+// every add() compiles to nothing.
+//
+// Each queue has a StatCounters member and a stats() method that merges
+// the per-thread counters; without QUEUE_STATS stats() is all zero.
+// Counters live on a cache line per thread (64 lines per queue, threads
+// beyond that share), so counting does not add the contention it is meant
+// to measure.
+#ifndef QUEUE_STATS
+#define QUEUE_STATS 0
+#endif
+
+enum queue_stat : int {
+    stat_head_cas_fail,   // lost a CAS on the head / dequeue side
+    stat_tail_cas_fail,   // lost a CAS on the tail / enqueue side
+    stat_full_wait,       // wait steps on a full ring
+    stat_empty_wait,      // wait steps on an empty queue
+    stat_yield,           // wait steps that yielded or slept
+    stat_cv_wait,         // condition_variable::wait calls (BlockingQueue)
+    stat_cv_notify,       // condition_variable notifies (BlockingQueue)
+    stat_retry,           // went round again for another reason: stale
+                          // index, slot lost to another thread, combiner busy
+    STAT_COUNT
+};
+
+static inline const char *stat_name(int s) {
+    static const char *const names[STAT_COUNT] = {"head_cas_fail", "tail_cas_fail", "full_waits", "empty_waits",
+                                                  "yields", "cv_waits", "cv_notifies", "retries"};
+    return s >= 0 && s < STAT_COUNT ? names[s] : "?";
+}
+
+struct QueueStats {
+    uint64_t count[STAT_COUNT] = {};
+
+    QueueStats &operator+=(const QueueStats &o) {
+        for (int i = 0; i < STAT_COUNT; ++i) count[i] += o.count[i];
+        return *this;
+    }
+};
+
+// small per-thread number, the same for every queue
+inline size_t stat_thread_slot() {
+    static std::atomic<size_t> next{0};
+    static thread_local size_t mine = next.fetch_add(1, std::memory_order_relaxed);
+    return mine;
+}
+
+template <bool Enabled = QUEUE_STATS != 0>
+class StatCounters {
+private:
+    static constexpr size_t SLOTS = 64;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> count[STAT_COUNT];
+    };
+
+    std::unique_ptr<Slot[]> slots{new Slot[SLOTS]()};
+
+public:
+    static constexpr bool enabled = true;
+
+    void add(queue_stat s, uint64_t n = 1) {
+        slots[stat_thread_slot() % SLOTS].count[s].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // one wait step on a full ring / empty queue; yielded: it yielded or slept
+    void full_wait(bool yielded) {
+        add(stat_full_wait);
+        if (yielded) add(stat_yield);
+    }
+
+    void empty_wait(bool yielded) {
+        add(stat_empty_wait);
+        if (yielded) add(stat_yield);
+    }
+
+    QueueStats merged() const {
+        QueueStats q;
+        for (size_t t = 0; t < SLOTS; ++t) {
+            for (int i = 0; i < STAT_COUNT; ++i) q.count[i] += slots[t].count[i].load(std::memory_order_relaxed);
+        }
+        return q;
+    }
+};
+
+template <>
+class StatCounters<false> {
+public:
+    static constexpr bool enabled = false;
+
+    void add(queue_stat, uint64_t = 1) {}
+    void full_wait(bool) {}
+    void empty_wait(bool) {}
+    QueueStats merged() const { return QueueStats(); }
+};
+
+#endif // QUEUE_STATS_HPP
@@ -7,11 +7,28 @@
 #include <cstdint>
 #include <vector>
 
-static inline std::vector<uint8_t> generate_random_bits(size_t total_ops, double ratio) {
+// xorshift64 step (Marsaglia): cheap per-thread randomness for victim and
+// heap choice; x must start non-zero
+static inline uint64_t xorshift64(uint64_t &x) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+// scrambles a seed, e.g. to derive per-thread seeds from one run seed
+static inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// same seed, same bits
+static inline std::vector<uint8_t> generate_random_bits(size_t total_ops, double ratio, uint64_t seed) {
     std::vector<uint8_t> v;
     v.reserve(total_ops);
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
     std::bernoulli_distribution d(ratio);
 
     for (size_t i = 0; i < total_ops; ++i) {
@@ -20,8 +37,10 @@ static inline std::vector<uint8_t> generate_random_bits(size_t total_ops, double
     return v;
 }
 
-static inline bool check_bits(std::vector<uint8_t>& bits) {
-    int balance_count = 0;
+// true if no dequeue (0) ever finds the balance at zero, starting from
+// `credit` items already queued
+static inline bool check_bits(const std::vector<uint8_t>& bits, size_t credit = 0) {
+    size_t balance_count = credit;
     for (auto b : bits) {
         if (balance_count == 0 && b == 0) return false;
         if (b == 1) balance_count++;
@@ -32,4 +51,4 @@ static inline bool check_bits(std::vector<uint8_t>& bits) {
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,178 @@
+#ifndef RING_STORAGE_HPP
+#define RING_STORAGE_HPP
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Storage for the ring-based queues' slot arrays, as an allocator that
+// plugs into NonBlockingQueue and BlockingQueue (their Alloc parameter).
+//
+//   storage_policy<Huge, Prefault, NumaLocal>
+//     Huge       huge_pages::none         4 KiB pages
+//                huge_pages::transparent  2 MiB aligned, madvise(MADV_HUGEPAGE)
+//                huge_pages::explicit_    MAP_HUGETLB from the reserved pool,
+//                                         transparent if none is reserved
+//     Prefault   touch every page at allocation, not in the first run
+//     NumaLocal  prefer the NUMA node of the allocating thread (mbind)
+//
+// Freed rings go back to StorageArena, which hands the same, already
+// faulted mapping to the next allocation of the same size and policy, so
+// only the first queue of a size pays for its page faults. trim() unmaps
+// the cached rings.
+enum class huge_pages { none, transparent, explicit_ };
+
+template <huge_pages Huge = huge_pages::none, bool Prefault = true, bool NumaLocal = false>
+struct storage_policy {
+    static constexpr huge_pages huge = Huge;
+    static constexpr bool prefault = Prefault;
+    static constexpr bool numa_local = NumaLocal;
+
+    static constexpr unsigned key() { return (unsigned)Huge | (Prefault ? 4u : 0u) | (NumaLocal ? 8u : 0u); }
+};
+
+class StorageArena {
+private:
+    static constexpr size_t PAGE = 4096;
+    static constexpr size_t HUGE_PAGE = 2 << 20;
+
+    struct Mapping {
+        void *ptr;
+        size_t bytes;     // as requested
+        unsigned key;
+        size_t mapped;    // length to munmap
+    };
+
+    std::mutex lock;
+    std::vector<Mapping> cached;
+    std::vector<Mapping> live;
+    size_t hugetlb_fallbacks = 0;
+
+    static size_t round_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+    // anonymous mapping of `bytes` aligned to `align`
+    static void *map_aligned(size_t bytes, size_t align, size_t &mapped) {
+        size_t len = bytes + align - PAGE;
+        void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        uintptr_t start = (uintptr_t)p, aligned = round_up(start, align);
+        if (aligned > start) munmap(p, aligned - start);
+        size_t tail = (start + len) - (aligned + bytes);
+        if (tail) munmap((void *)(aligned + bytes), tail);
+        mapped = bytes;
+        return (void *)aligned;
+    }
+
+    static void prefer_local_node(void *p, size_t bytes) {
+        unsigned cpu = 0, node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return;
+        unsigned long mask[16] = {0};
+        if (node >= sizeof(mask) * 8) return;
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        // single-node machines and kernels without NUMA just refuse
+        syscall(SYS_mbind, p, bytes, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0);
+    }
+
+    template <typename Policy>
+    void *map_new(size_t bytes, size_t &mapped) {
+        void *p = nullptr;
+        bool huge = Policy::huge != huge_pages::none;
+        size_t len = round_up(bytes, huge ? HUGE_PAGE : PAGE);
+        if (Policy::huge == huge_pages::explicit_) {
+            p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) {
+                p = nullptr;
+                ++hugetlb_fallbacks;
+            } else {
+                mapped = len;
+            }
+        }
+        if (!p) p = map_aligned(len, huge ? HUGE_PAGE : PAGE, mapped);
+        if (!p) throw std::bad_alloc();
+
+        if (Policy::numa_local) prefer_local_node(p, mapped);
+        if (huge) madvise(p, mapped, MADV_HUGEPAGE);
+        if (Policy::prefault) {
+            for (size_t off = 0; off < mapped; off += PAGE) static_cast<volatile char *>(p)[off] = 0;
+        }
+        return p;
+    }
+
+public:
+    static StorageArena &instance() {
+        static StorageArena arena;
+        return arena;
+    }
+
+    ~StorageArena() { trim(); }
+
+    template <typename Policy>
+    void *acquire(size_t bytes) {
+        std::lock_guard<std::mutex> guard(lock);
+        Mapping m{nullptr, bytes, Policy::key(), 0};
+        for (size_t i = 0; i < cached.size(); ++i) {
+            if (cached[i].bytes == bytes && cached[i].key == m.key) {
+                m = cached[i];
+                cached.erase(cached.begin() + i);
+                break;
+            }
+        }
+        if (!m.ptr) m.ptr = map_new<Policy>(bytes, m.mapped);
+        live.push_back(m);
+        return m.ptr;
+    }
+
+    void release(void *p) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (live[i].ptr == p) {
+                cached.push_back(live[i]);
+                live.erase(live.begin() + i);
+                return;
+            }
+        }
+    }
+
+    // unmap every cached ring; the next allocations fault again
+    void trim() {
+        std::lock_guard<std::mutex> guard(lock);
+        for (const Mapping &m : cached) munmap(m.ptr, m.mapped);
+        cached.clear();
+    }
+
+    // MAP_HUGETLB requests that found no reserved huge page
+    size_t fallbacks() {
+        std::lock_guard<std::mutex> guard(lock);
+        return hugetlb_fallbacks;
+    }
+};
+
+template <typename T, typename Policy = storage_policy<>>
+struct ring_allocator {
+    typedef T value_type;
+
+    ring_allocator() = default;
+    template <typename U>
+    ring_allocator(const ring_allocator<U, Policy> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(StorageArena::instance().acquire<Policy>(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t) { StorageArena::instance().release(p); }
+
+    template <typename U>
+    bool operator==(const ring_allocator<U, Policy> &) const { return true; }
+    template <typename U>
+    bool operator!=(const ring_allocator<U, Policy> &) const { return false; }
+};
+
+#endif // RING_STORAGE_HPP
@@ -0,0 +1,218 @@
+#ifndef ROLE_QUEUE_HPP
+#define ROLE_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "eventcount.hpp"
+#include "noblocking_queue.hpp"
+#include "slot_storage.hpp"
+
+// Bounded rings specialised for how many threads add and remove.
+//
+//   RoleQueue<T, role::spsc>   Lamport ring, each side caches the other's index
+//   RoleQueue<T, role::mpsc>   Vyukov ring, CAS on tail only
+//   RoleQueue<T, role::spmc>   Vyukov ring, CAS on head only
+//   RoleQueue<T, role::mpmc>   NonBlockingQueue
+//
+// All of them have add/remove like the other queues. Capacity is rounded
+// up to a power of two. Using a single-sided variant from more threads
+// than its role allows is a data race.
+enum class role { spsc, mpsc, spmc, mpmc };
+
+static inline const char *role_name(role r) {
+    switch (r) {
+    case role::spsc: return "spsc";
+    case role::mpsc: return "mpsc";
+    case role::spmc: return "spmc";
+    case role::mpmc: return "mpmc";
+    }
+    return "?";
+}
+
+static inline size_t pow2_at_least(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+template <typename T, typename Wait = spin_wait>
+class SPSCQueue {
+private:
+    size_t mask;
+    std::vector<RawSlot<T>> buffer;
+
+    // consumer side
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+    // producer side
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+
+    alignas(64) Wait not_full;
+    alignas(64) Wait not_empty;
+
+public:
+    typedef T value_type;
+
+    explicit SPSCQueue(size_t capacity) : mask(pow2_at_least(capacity) - 1), buffer(mask + 1) {}
+
+    ~SPSCQueue() {
+        if (std::is_trivially_destructible<T>::value) return;
+        size_t t = tail.load(std::memory_order_relaxed);
+        for (size_t h = head.load(std::memory_order_relaxed); h != t; ++h) buffer[h & mask].destroy();
+    }
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while (t - cached_head > mask) {
+            // looks full, refresh the consumer's index
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask) {
+                not_full.await([&]() { return t - head.load(std::memory_order_acquire) <= mask; });
+            }
+        }
+        buffer[t & mask].emplace(std::forward<Args>(args)...);
+        tail.store(t + 1, std::memory_order_release);
+        not_empty.notify_one();
+    }
+
+    T remove() {
+        size_t h = head.load(std::memory_order_relaxed);
+        while (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) {
+                not_empty.await([&]() { return h != tail.load(std::memory_order_acquire); });
+            }
+        }
+        T out = buffer[h & mask].take();
+        head.store(h + 1, std::memory_order_release);
+        not_full.notify_one();
+        return out;
+    }
+};
+
+// Vyukov ring where only the shared side pays for a CAS.
+template <typename T, bool MultiProducer, bool MultiConsumer, typename Wait = spin_wait>
+class SeqRingQueue {
+private:
+    struct Node {
+        std::atomic<size_t> seq;
+        RawSlot<T> data;
+    };
+
+    size_t mask;
+    std::vector<Node> buffer;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) Wait not_full;
+    alignas(64) Wait not_empty;
+
+    bool can_add() const {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        return (intptr_t)buffer[pos & mask].seq.load(std::memory_order_acquire) - (intptr_t)pos >= 0;
+    }
+
+    bool can_remove() const {
+        size_t pos = head.load(std::memory_order_relaxed);
+        return (intptr_t)buffer[pos & mask].seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1) >= 0;
+    }
+
+public:
+    typedef T value_type;
+
+    explicit SeqRingQueue(size_t capacity) : mask(pow2_at_least(capacity) - 1), buffer(mask + 1) {
+        for (size_t i = 0; i <= mask; ++i) {
+            buffer[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~SeqRingQueue() {
+        if (std::is_trivially_destructible<T>::value) return;
+        size_t t = tail.load(std::memory_order_relaxed);
+        for (size_t h = head.load(std::memory_order_relaxed); h != t; ++h) buffer[h & mask].data.destroy();
+    }
+
+    SeqRingQueue(const SeqRingQueue &) = delete;
+    SeqRingQueue &operator=(const SeqRingQueue &) = delete;
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        while (true) {
+            size_t pos = tail.load(std::memory_order_relaxed);
+            Node &node = buffer[pos & mask];
+            intptr_t dif = (intptr_t)node.seq.load(std::memory_order_acquire) - (intptr_t)pos;
+            if (dif == 0) {
+                if (MultiProducer) {
+                    if (!tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) continue;
+                } else {
+                    tail.store(pos + 1, std::memory_order_relaxed);
+                }
+                node.data.emplace(std::forward<Args>(args)...);
+                node.seq.store(pos + 1, std::memory_order_release);
+                not_empty.notify_one();
+                return;
+            } else if (dif < 0) {
+                // full
+                not_full.await([this]() { return can_add(); });
+            }
+        }
+    }
+
+    T remove() {
+        while (true) {
+            size_t pos = head.load(std::memory_order_relaxed);
+            Node &node = buffer[pos & mask];
+            intptr_t dif = (intptr_t)node.seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (MultiConsumer) {
+                    if (!head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) continue;
+                } else {
+                    head.store(pos + 1, std::memory_order_relaxed);
+                }
+                T out = node.data.take();
+                node.seq.store(pos + mask + 1, std::memory_order_release);
+                not_full.notify_one();
+                return out;
+            } else if (dif < 0) {
+                // empty
+                not_empty.await([this]() { return can_remove(); });
+            }
+        }
+    }
+};
+
+template <typename T, role R, typename Wait> struct role_queue_select;
+template <typename T, typename Wait> struct role_queue_select<T, role::spsc, Wait> {
+    typedef SPSCQueue<T, Wait> type;
+};
+template <typename T, typename Wait> struct role_queue_select<T, role::mpsc, Wait> {
+    typedef SeqRingQueue<T, true, false, Wait> type;
+};
+template <typename T, typename Wait> struct role_queue_select<T, role::spmc, Wait> {
+    typedef SeqRingQueue<T, false, true, Wait> type;
+};
+template <typename T, typename Wait> struct role_queue_select<T, role::mpmc, Wait> {
+    typedef NonBlockingQueue<T, nbq_layout<true, false, true>, Wait> type;
+};
+
+template <typename T, role R, typename Wait = spin_wait>
+using RoleQueue = typename role_queue_select<T, R, Wait>::type;
+
+#endif // ROLE_QUEUE_HPP
@@ -0,0 +1,96 @@
+#ifndef SEQ_RING_HPP
+#define SEQ_RING_HPP
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+#include "queue_stats.hpp"
+
+// The bounded MPMC ring (Vyukov) behind NonBlockingQueue and ShmQueue,
+// written once over where the ring lives (CRTP base).
+//
+// Every slot has a sequence number: seq == pos means free for the
+// producer of position pos, seq == pos + 1 means filled for its consumer,
+// and draining hands the slot to the next lap with seq = pos + capacity.
+// Producers and consumers claim positions with one CAS on tail / head.
+//
+// Derived supplies the storage and befriends SeqRing:
+//   std::atomic<Index> &ring_head(), &ring_tail()
+//   Node &ring_node(Index pos)     slot of position pos; Node has
+//                                  std::atomic<Index> seq and RawSlot<T> data
+//   Index ring_capacity()
+//   void ring_count(queue_stat)    telemetry hook for CAS failures / retries
+template <typename Derived, typename T, typename Index>
+class SeqRing {
+protected:
+    typedef typename std::make_signed<Index>::type Diff;
+
+    bool can_add() {
+        Index pos = self().ring_tail().load(std::memory_order_relaxed);
+        return (Diff)self().ring_node(pos).seq.load(std::memory_order_acquire) - (Diff)pos >= 0;
+    }
+
+    bool can_remove() {
+        Index pos = self().ring_head().load(std::memory_order_relaxed);
+        return (Diff)self().ring_node(pos).seq.load(std::memory_order_acquire) - (Diff)(pos + 1) >= 0;
+    }
+
+    // Claim the slot at tail / head with one CAS; false if full / empty.
+    bool claim_back(Index &pos) {
+        std::atomic<Index> &tail = self().ring_tail();
+        while (true) {
+            pos = tail.load(std::memory_order_relaxed);
+            Index seq = self().ring_node(pos).seq.load(std::memory_order_acquire);
+            Diff dif = (Diff)seq - (Diff)pos;
+            if (dif == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return true;
+                self().ring_count(stat_tail_cas_fail);
+            } else if (dif < 0) {
+                return false;
+            } else {
+                self().ring_count(stat_retry);
+            }
+        }
+    }
+
+    bool claim_front(Index &pos) {
+        std::atomic<Index> &head = self().ring_head();
+        while (true) {
+            pos = head.load(std::memory_order_relaxed);
+            Index seq = self().ring_node(pos).seq.load(std::memory_order_acquire);
+            Diff dif = (Diff)seq - (Diff)(pos + 1);
+            if (dif == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return true;
+                self().ring_count(stat_head_cas_fail);
+            } else if (dif < 0) {
+                return false;
+            } else {
+                self().ring_count(stat_retry);
+            }
+        }
+    }
+
+    // construct the value of a claimed tail slot and hand it to consumers
+    template <typename... Args>
+    void publish(Index pos, Args &&...args) {
+        auto &node = self().ring_node(pos);
+        node.data.emplace(std::forward<Args>(args)...);
+        node.seq.store(pos + 1, std::memory_order_release);
+    }
+
+    // move the value out of a claimed head slot and hand the slot back
+    T release(Index pos) {
+        auto &node = self().ring_node(pos);
+        T out = node.data.take();
+        node.seq.store(pos + self().ring_capacity(), std::memory_order_release);
+        return out;
+    }
+
+private:
+    Derived &self() { return static_cast<Derived &>(*this); }
+};
+
+#endif // SEQ_RING_HPP
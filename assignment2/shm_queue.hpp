@@ -0,0 +1,329 @@
+#ifndef SHM_QUEUE_HPP
+#define SHM_QUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "eventcount.hpp"
+#include "slot_storage.hpp"
+#include "seq_ring.hpp"
+
+// NonBlockingQueue's ring (SeqRing, seq_ring.hpp) in a named POSIX
+// shared-memory segment, for processes that exchange items without a
+// kernel copy.
+//
+//   ShmQueue<T> q = ShmQueue<T>::create("/name", capacity);   // one process
+//   ShmQueue<T> q = ShmQueue<T>::attach("/name");             // the others
+//   ...
+//   ShmQueue<T>::unlink("/name");    // once nobody needs to attach any more
+//
+// The segment is a versioned header followed by the slots. Nothing in it
+// is a pointer, every process maps it at its own address and finds the
+// slots at header.slots_offset. attach() checks magic, version and item
+// size before it touches anything. T must be trivially copyable, it is
+// copied between address spaces byte for byte.
+//
+// Each attached process holds a pid in the header's peer table; the
+// destructor (detach) clears it. A process that dies without detaching
+// leaves its pid behind: add() and remove() check the table while they
+// wait on a full / empty queue and throw std::runtime_error once no other
+// live process is attached, rather than wait forever on a dead peer. A
+// peer that dies between claiming a slot and filling it leaves that slot
+// stuck; the queue has to be recreated after that.
+template <typename T>
+class ShmQueue : public SeqRing<ShmQueue<T>, T, uint64_t> {
+private:
+    typedef SeqRing<ShmQueue, T, uint64_t> Ring;
+    friend Ring;
+
+    using Ring::claim_back;
+    using Ring::claim_front;
+
+    static_assert(std::is_trivially_copyable<T>::value, "ShmQueue items are copied between processes");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+
+    static constexpr uint64_t MAGIC = 0x51554555454d4853ull;   // "SHMEUEUQ"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int MAX_PEERS = 8;
+    static constexpr int PEER_CHECK = 1024;    // waiting backoff steps between peer checks
+
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t item_size;
+        uint64_t capacity;        // power of two
+        uint64_t slots_offset;    // from the start of the segment
+        uint64_t segment_size;
+        std::atomic<uint32_t> ready;
+        std::atomic<int32_t> peers[MAX_PEERS];
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+    };
+
+    struct alignas(std::atomic<uint64_t>) alignas(T) Slot {
+        std::atomic<uint64_t> seq;
+        RawSlot<T> data;
+    };
+
+    Header *hdr = nullptr;
+    Slot *slots = nullptr;
+    uint64_t mask = 0;
+    int32_t self = 0;
+
+    static size_t slots_offset() {
+        return (sizeof(Header) + 63) / 64 * 64;
+    }
+
+    static void fail(const char *what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    ShmQueue(void *base, int32_t pid)
+        : hdr(static_cast<Header *>(base)),
+          slots(reinterpret_cast<Slot *>(static_cast<char *>(base) + hdr->slots_offset)),
+          mask(hdr->capacity - 1), self(pid) {}
+
+    static bool alive(int32_t pid) {
+        if (pid <= 0 || (kill(pid, 0) != 0 && errno != EPERM)) return false;
+        // a dead child its parent has not reaped yet still answers kill()
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+        FILE *f = fopen(path, "r");
+        if (!f) return true;
+        char buf[256];
+        size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+        fclose(f);
+        buf[n] = 0;
+        const char *state = strrchr(buf, ')');
+        return !(state && state[1] == ' ' && (state[2] == 'Z' || state[2] == 'X'));
+    }
+
+    // take a free or dead entry in the peer table
+    void join() {
+        for (int i = 0; i < MAX_PEERS; ++i) {
+            int32_t p = hdr->peers[i].load(std::memory_order_relaxed);
+            if ((p == 0 || !alive(p)) &&
+                hdr->peers[i].compare_exchange_strong(p, self, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+        throw std::runtime_error("ShmQueue: too many processes attached");
+    }
+
+    void leave() {
+        for (int i = 0; i < MAX_PEERS; ++i) {
+            int32_t p = self;
+            if (hdr->peers[i].compare_exchange_strong(p, 0, std::memory_order_acq_rel)) return;
+        }
+    }
+
+    bool others_alive() const {
+        for (int i = 0; i < MAX_PEERS; ++i) {
+            int32_t p = hdr->peers[i].load(std::memory_order_acquire);
+            if (p != 0 && p != self && alive(p)) return true;
+        }
+        return false;
+    }
+
+    // called between backoff steps of a blocking add/remove
+    void check_peers(int &steps) const {
+        if (++steps % PEER_CHECK == 0 && !others_alive()) {
+            throw std::runtime_error("ShmQueue: no live peer attached");
+        }
+    }
+
+    // SeqRing storage: indices in the header, slots after it
+    std::atomic<uint64_t> &ring_head() { return hdr->head; }
+    std::atomic<uint64_t> &ring_tail() { return hdr->tail; }
+    Slot &ring_node(uint64_t pos) { return slots[pos & mask]; }
+    uint64_t ring_capacity() const { return mask + 1; }
+    void ring_count(queue_stat) {}
+
+    static void *map(int fd, size_t size) {
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) fail("mmap");
+        return p;
+    }
+
+public:
+    typedef T value_type;
+
+    // Create and initialise the segment; fails if the name exists.
+    static ShmQueue create(const std::string &name, size_t capacity) {
+        uint64_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        size_t size = slots_offset() + cap * sizeof(Slot);
+
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) fail("shm_open");
+        if (ftruncate(fd, (off_t)size) != 0) {
+            int e = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            errno = e;
+            fail("ftruncate");
+        }
+        void *base = map(fd, size);
+        close(fd);
+
+        // the fresh segment is zero-filled
+        Header *h = new (base) Header;
+        h->magic = MAGIC;
+        h->version = VERSION;
+        h->item_size = sizeof(T);
+        h->capacity = cap;
+        h->slots_offset = slots_offset();
+        h->segment_size = size;
+        Slot *s = reinterpret_cast<Slot *>(static_cast<char *>(base) + h->slots_offset);
+        for (uint64_t i = 0; i < cap; ++i) s[i].seq.store(i, std::memory_order_relaxed);
+
+        ShmQueue q(base, (int32_t)getpid());
+        q.join();
+        h->ready.store(1, std::memory_order_release);
+        return q;
+    }
+
+    // Map a segment made by create(), waiting up to `timeout` for it to
+    // be initialised.
+    static ShmQueue attach(const std::string &name,
+                           std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) {
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0) fail("shm_open");
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        struct stat st;
+        do {
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                fail("fstat");
+            }
+            if ((size_t)st.st_size >= sizeof(Header)) break;
+            spin_backoff();
+        } while (std::chrono::steady_clock::now() < deadline);
+        if ((size_t)st.st_size < sizeof(Header)) {
+            close(fd);
+            throw std::runtime_error("ShmQueue: segment too small");
+        }
+        void *base = map(fd, st.st_size);
+        close(fd);
+
+        Header *h = static_cast<Header *>(base);
+        while (h->ready.load(std::memory_order_acquire) == 0 && std::chrono::steady_clock::now() < deadline) {
+            spin_backoff();
+        }
+        const char *bad = nullptr;
+        if (h->ready.load(std::memory_order_acquire) == 0) bad = "ShmQueue: segment never initialised";
+        else if (h->magic != MAGIC) bad = "ShmQueue: not a queue segment";
+        else if (h->version != VERSION) bad = "ShmQueue: layout version mismatch";
+        else if (h->item_size != sizeof(T)) bad = "ShmQueue: item size mismatch";
+        else if (h->segment_size != (uint64_t)st.st_size ||
+                 h->slots_offset + h->capacity * sizeof(Slot) > h->segment_size) {
+            bad = "ShmQueue: segment size mismatch";
+        }
+        if (bad) {
+            munmap(base, st.st_size);
+            throw std::runtime_error(bad);
+        }
+
+        ShmQueue q(base, (int32_t)getpid());
+        q.join();
+        return q;
+    }
+
+    static void unlink(const std::string &name) { shm_unlink(name.c_str()); }
+
+    ShmQueue(ShmQueue &&o) noexcept : hdr(o.hdr), slots(o.slots), mask(o.mask), self(o.self) {
+        o.hdr = nullptr;
+    }
+
+    ShmQueue(const ShmQueue &) = delete;
+    ShmQueue &operator=(const ShmQueue &) = delete;
+    ShmQueue &operator=(ShmQueue &&) = delete;
+
+    // detach
+    ~ShmQueue() {
+        if (!hdr) return;
+        leave();
+        munmap(hdr, hdr->segment_size);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    void add(const T &item) {
+        uint64_t pos;
+        int steps = 0;
+        while (!claim_back(pos)) {
+            // full
+            check_peers(steps);
+            spin_backoff();
+        }
+        this->publish(pos, item);
+    }
+
+    T remove() {
+        uint64_t pos;
+        int steps = 0;
+        while (!claim_front(pos)) {
+            // empty
+            check_peers(steps);
+            spin_backoff();
+        }
+        return this->release(pos);
+    }
+
+    bool try_add(const T &item) {
+        uint64_t pos;
+        if (!claim_back(pos)) return false;
+        this->publish(pos, item);
+        return true;
+    }
+
+    bool try_remove(T &out) {
+        uint64_t pos;
+        if (!claim_front(pos)) return false;
+        out = this->release(pos);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_add_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_add(item)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            spin_backoff();
+        }
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_remove(out)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            spin_backoff();
+        }
+        return true;
+    }
+
+    // is another process that has not detached still running
+    bool peer_alive() const { return others_alive(); }
+};
+
+#endif // SHM_QUEUE_HPP
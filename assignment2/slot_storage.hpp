@@ -0,0 +1,36 @@
+#ifndef SLOT_STORAGE_HPP
+#define SLOT_STORAGE_HPP
+
+#pragma once
+
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// Uninitialised storage for one T inside a queue slot. The queue decides
+// when a value lives there: emplace() constructs it in place, take() moves
+// it out and destroys what is left, so T needs neither a default
+// constructor nor a copy.
+template <typename T>
+struct RawSlot {
+    alignas(T) unsigned char bytes[sizeof(T)];
+
+    T *ptr() { return std::launder(reinterpret_cast<T *>(bytes)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        ::new (static_cast<void *>(bytes)) T(std::forward<Args>(args)...);
+    }
+
+    T take() {
+        T out(std::move(*ptr()));
+        destroy();
+        return out;
+    }
+
+    void destroy() {
+        if (!std::is_trivially_destructible<T>::value) ptr()->~T();
+    }
+};
+
+#endif // SLOT_STORAGE_HPP
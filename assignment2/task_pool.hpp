@@ -0,0 +1,167 @@
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include "chase_lev_deque.hpp"
+#include "eventcount.hpp"
+#include "random_bits.hpp"
+
+// Fork/join thread pool.
+//
+//   TaskPool<Q, true>    work stealing: each worker owns a ChaseLevDeque,
+//                        Q is only the injection queue for tasks spawned
+//                        from outside the pool
+//   TaskPool<Q, false>   every task goes through the one shared queue Q
+//
+// Q is any of our queues over pool_task* with try_add/try_remove. If it
+// is full the spawning thread runs the task itself.
+//
+//   TaskGroup g;
+//   pool.spawn(g, [&]() { ... });
+//   pool.wait(g);      // runs other tasks until all of g's are done
+//
+// The thread that constructs the pool is its worker 0 and only does work
+// while inside wait(); the other threads - 1 workers spin (with backoff)
+// until the pool is destroyed.
+struct TaskGroup {
+    std::atomic<size_t> pending{0};
+};
+
+struct pool_task {
+    std::function<void()> fn;
+    TaskGroup *group;
+};
+
+template <typename Injection, bool Steal = true>
+class TaskPool {
+private:
+    static_assert(std::is_same<typename Injection::value_type, pool_task *>::value,
+                  "the injection queue holds pool_task*");
+
+    struct alignas(64) Worker {
+        ChaseLevDeque<pool_task *> deque;
+        uint64_t rng;
+    };
+
+    struct Current {
+        const TaskPool *pool;
+        size_t index;
+    };
+
+    // which pool worker the calling thread is, if any
+    static Current &current() {
+        static thread_local Current c{nullptr, 0};
+        return c;
+    }
+
+    size_t n;
+    std::unique_ptr<Worker[]> workers;
+    Injection injection;
+    std::vector<std::thread> pool_threads;
+    alignas(64) std::atomic<bool> stop{false};
+
+    static void run(pool_task *t) {
+        TaskGroup *g = t->group;
+        t->fn();
+        delete t;
+        g->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    // own deque first, then the injection queue, then the other workers
+    // starting from a random one; self == n for a thread outside the pool
+    pool_task *find_task(size_t self) {
+        pool_task *t;
+        if (Steal && self < n && workers[self].deque.pop(t)) return t;
+        if (injection.try_remove(t)) return t;
+        if (Steal && n > 1) {
+            uint64_t r = self < n ? xorshift64(workers[self].rng) : 0;
+            for (size_t k = 0; k < n; ++k) {
+                size_t victim = (r + k) % n;
+                if (victim != self && workers[victim].deque.steal(t)) return t;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t self_index() const {
+        const Current &c = current();
+        return c.pool == this ? c.index : n;
+    }
+
+public:
+    // on_start(i) is called first thing on worker thread i (1..threads-1),
+    // e.g. to pin it
+    explicit TaskPool(size_t threads, size_t injection_capacity = 1 << 16,
+                      std::function<void(size_t)> on_start = nullptr)
+        : n(threads < 1 ? 1 : threads), workers(new Worker[n]), injection(injection_capacity) {
+        for (size_t i = 0; i < n; ++i) workers[i].rng = 0x9E3779B97F4A7C15ull * (i + 1);
+        current() = Current{this, 0};
+        for (size_t i = 1; i < n; ++i) {
+            pool_threads.emplace_back([this, i, on_start]() {
+                if (on_start) on_start(i);
+                current() = Current{this, i};
+                while (!stop.load(std::memory_order_relaxed)) {
+                    if (pool_task *t = find_task(i)) {
+                        run(t);
+                    } else {
+                        spin_backoff();
+                    }
+                }
+                current() = Current{nullptr, 0};
+            });
+        }
+    }
+
+    ~TaskPool() {
+        stop.store(true, std::memory_order_relaxed);
+        for (auto &th : pool_threads) th.join();
+        if (current().pool == this) current() = Current{nullptr, 0};
+        // only tasks nobody waited for are left
+        pool_task *t;
+        while (injection.try_remove(t)) delete t;
+        for (size_t i = 0; i < n; ++i) {
+            while (workers[i].deque.pop(t)) delete t;
+        }
+    }
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    size_t size() const { return n; }
+
+    template <typename F>
+    void spawn(TaskGroup &g, F &&f) {
+        g.pending.fetch_add(1, std::memory_order_relaxed);
+        pool_task *t = new pool_task{std::forward<F>(f), &g};
+        size_t self = self_index();
+        if (Steal && self < n) {
+            workers[self].deque.push(t);
+        } else if (!injection.try_add(t)) {
+            run(t);
+        }
+    }
+
+    void wait(TaskGroup &g) {
+        size_t self = self_index();
+        while (g.pending.load(std::memory_order_acquire) != 0) {
+            if (pool_task *t = find_task(self)) {
+                run(t);
+            } else {
+                spin_backoff();
+            }
+        }
+    }
+};
+
+#endif // TASK_POOL_HPP
@@ -5,26 +5,62 @@
 
 #include <tbb/concurrent_queue.h>
 #include <stdexcept>
+#include <optional>
+#include <utility>
+#include <chrono>
 
-template <typename T>
-class TBBQueue {
+#include "eventcount.hpp"
+#include "queue_stats.hpp"
+#include "queue_ops.hpp"
+
+// Wait: spin_wait (yield until try_pop succeeds) or eventcount_wait
+//
+// Elements are held as std::optional<T> because try_pop needs a default
+// constructed destination to move into.
+template <typename T, typename Wait = spin_wait>
+class TBBQueue : public unbounded_add<TBBQueue<T, Wait>, T> {
 private:
-    tbb::concurrent_queue<T> queue;
+    tbb::concurrent_queue<std::optional<T>> queue;
+    Wait not_empty;
+    StatCounters<> counters;
 
 public:
+    typedef T value_type;
+
     explicit TBBQueue(size_t) {}
 
-    void add(const T &item) {
-        queue.push(item);
+    // the tbb internals are not counted
+    QueueStats stats() const { return counters.merged(); }
+
+    void add(const T &item) { emplace(item); }
+    void add(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        queue.emplace(std::in_place, std::forward<Args>(args)...);
+        not_empty.notify_one();
     }
 
     T remove() {
-        T out;
+        std::optional<T> out;
         while (!queue.try_pop(out)) {
-            std::this_thread::yield();
+            counters.empty_wait(not_empty.await([this]() { return !queue.empty(); }));
         }
-        return out;
+        return std::move(*out);
+    }
+
+    bool try_remove(T &out) {
+        std::optional<T> tmp;
+        if (!queue.try_pop(tmp)) return false;
+        out = std::move(*tmp);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_remove_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+        return retry_until(not_empty, std::chrono::steady_clock::now() + timeout, [&]() { return try_remove(out); },
+                           [this]() { return !queue.empty(); }, [this](bool gave_up) { counters.empty_wait(gave_up); });
     }
 };
 
-#endif // TBB_QUEUE_HPP
\ No newline at end of file
+#endif // TBB_QUEUE_HPP
@@ -0,0 +1,330 @@
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+#include "random_bits.hpp"
+
+// Reproducible operation sequences for the mixed-style benchmarks.
+//
+// Every thread gets its own op sequence (1 = add, 0 = remove) from its own
+// generator, seeded from the run seed and the thread id, so a point is the
+// same on every run and for every queue. Each thread is also credited an
+// equal share of the prefill, and its sequence never removes more than
+// that share plus its own adds so far (check_bits with that credit). Then
+// whenever a thread removes, the queue holds at least one item, whatever
+// the interleaving, and no remover can wait forever. Likewise the prefill
+// plus every thread's peak of unmatched adds must fit the queue's
+// capacity, or an adder could wait forever on a full queue.
+//
+//   random     adds and removes shuffled, add fraction = ratio
+//   bursty     the same counts in runs of one op (mean BURST_LENGTH)
+//   patterned  generate_ops_patterned: fixed add/remove phases, always
+//              ratio PATTERNED_RATIO (other ratios are rejected)
+//
+// A workload can be written to and read back from a binary trace file.
+
+enum class workload_kind { random, bursty, patterned };
+
+static inline const char *workload_name(workload_kind k) {
+    switch (k) {
+    case workload_kind::random: return "random";
+    case workload_kind::bursty: return "bursty";
+    case workload_kind::patterned: return "patterned";
+    }
+    return "?";
+}
+
+static inline bool parse_workload(const std::string &s, workload_kind &out) {
+    if (s == "random") out = workload_kind::random;
+    else if (s == "bursty") out = workload_kind::bursty;
+    else if (s == "patterned") out = workload_kind::patterned;
+    else return false;
+    return true;
+}
+
+struct WorkloadConfig {
+    workload_kind kind = workload_kind::random;
+    uint64_t seed = 1;
+    // trace mode only
+    int threads = 8;
+    double ratio = 0.5;
+    std::string record;
+    std::string replay;
+};
+
+inline WorkloadConfig &workload_config() {
+    static WorkloadConfig cfg;
+    return cfg;
+}
+
+const size_t BURST_LENGTH = 64;
+const double PATTERNED_RATIO = 0.5;   // add fraction of generate_ops_patterned
+
+struct Workload {
+    workload_kind kind = workload_kind::random;
+    uint64_t seed = 0;
+    double ratio = 0;
+    size_t prefill = 0;                        // items added before the run
+    std::vector<std::vector<uint8_t>> ops;     // per thread
+
+    size_t threads() const { return ops.size(); }
+
+    size_t total() const {
+        size_t n = 0;
+        for (const auto &o : ops) n += o.size();
+        return n;
+    }
+
+    // add fraction actually generated
+    double add_fraction() const {
+        size_t adds = 0;
+        for (const auto &o : ops) adds += std::count(o.begin(), o.end(), 1);
+        return total() ? (double)adds / total() : 0;
+    }
+};
+
+static inline uint64_t thread_seed(uint64_t seed, size_t tid) {
+    return splitmix64(splitmix64(seed) + tid);
+}
+
+static inline std::vector<uint8_t> generate_ops_patterned(size_t total_ops) {
+    std::vector<uint8_t> v;
+    v.reserve(total_ops);
+    // 定义模式：pair<count, op>，op: 1=enq, 0=deq
+    const std::vector<std::pair<size_t,uint8_t>> pattern = {
+        {1024, 1}, // 1024 enq
+        {512,  0}, // 512 deq
+        {1024, 1}, // 1024 enq
+        {1536, 0}  // 1536 deq
+    };
+    while (v.size() < total_ops) {
+        for (const auto &p : pattern) {
+            size_t cnt = p.first;
+            uint8_t op = p.second;
+            for (size_t i = 0; i < cnt && v.size() < total_ops; ++i) {
+                v.push_back(op);
+            }
+            if (v.size() >= total_ops) break;
+        }
+    }
+    return v;
+}
+
+// n ops with exactly `adds` adds, in runs of mean length `burst` (1 = no
+// bursts). A remove is only placed while credit + adds - removes so far is
+// positive; needs n - adds <= credit + adds.
+static inline std::vector<uint8_t> generate_ops_balanced(size_t n, size_t adds, size_t credit, size_t burst,
+                                                         std::mt19937_64 &gen) {
+    std::vector<uint8_t> v;
+    v.reserve(n);
+    size_t adds_left = adds, removes_left = n - adds;
+    size_t balance = credit;
+    std::geometric_distribution<size_t> run(1.0 / burst);
+
+    while (adds_left + removes_left > 0) {
+        // pick the op in proportion to what is left, so the mix stays even
+        std::uniform_int_distribution<size_t> pick(0, adds_left + removes_left - 1);
+        bool add = pick(gen) < adds_left || balance == 0;
+        size_t len = burst > 1 ? run(gen) + 1 : 1;
+        len = std::min(len, add ? adds_left : std::min(removes_left, balance));
+        for (size_t i = 0; i < len; ++i) v.push_back(add ? 1 : 0);
+        if (add) {
+            adds_left -= len;
+            balance += len;
+        } else {
+            removes_left -= len;
+            balance -= len;
+        }
+    }
+    return v;
+}
+
+// Most items the queue can hold while w runs: the prefill plus, per
+// thread, the peak of its adds less its removes so far (the threads may
+// all reach their peaks at once).
+static inline uint64_t workload_peak_items(const Workload &w) {
+    uint64_t peak_items = w.prefill;
+    for (const auto &o : w.ops) {
+        int64_t balance = 0, peak = 0;
+        for (uint8_t op : o) {
+            balance += op ? 1 : -1;
+            peak = std::max(peak, balance);
+        }
+        peak_items += peak;
+    }
+    return peak_items;
+}
+
+// total_ops split evenly over the threads, prefill credited the same way.
+// The add count is raised if the ratio would need more removes than a
+// thread can be given items for. Throws std::invalid_argument if ratio is
+// not in [0, 1] (or not PATTERNED_RATIO for patterned) or the workload
+// could overfill a queue of `capacity`.
+static inline Workload make_workload(size_t threads, size_t total_ops, double ratio, size_t prefill,
+                                     size_t capacity, workload_kind kind, uint64_t seed) {
+    if (threads == 0) throw std::invalid_argument("make_workload: no threads");
+    if (!(ratio >= 0 && ratio <= 1)) throw std::invalid_argument("make_workload: ratio must be in [0, 1]");
+    if (kind == workload_kind::patterned && ratio != PATTERNED_RATIO) {
+        throw std::invalid_argument("make_workload: the patterned workload only has ratio 0.5");
+    }
+    if (prefill > capacity) throw std::invalid_argument("make_workload: prefill exceeds the queue capacity");
+
+    Workload w;
+    w.kind = kind;
+    w.seed = seed;
+    w.ratio = ratio;
+    w.prefill = prefill;
+    w.ops.resize(threads);
+
+    std::vector<size_t> share(threads, total_ops / threads), credit(threads, prefill / threads);
+    for (size_t t = 0; t < total_ops % threads; ++t) ++share[t];
+    for (size_t t = 0; t < prefill % threads; ++t) ++credit[t];
+
+    for (size_t t = 0; t < threads; ++t) {
+        size_t n = share[t];
+        if (kind == workload_kind::patterned) {
+            w.ops[t] = generate_ops_patterned(n);
+            continue;
+        }
+        size_t adds = std::min(n, (size_t)std::llround(ratio * n));
+        if (n > credit[t]) adds = std::max(adds, (n - credit[t] + 1) / 2);
+        std::mt19937_64 gen(thread_seed(seed, t));
+        w.ops[t] = generate_ops_balanced(n, adds, credit[t],
+                                         kind == workload_kind::bursty ? BURST_LENGTH : 1, gen);
+    }
+    if (workload_peak_items(w) > capacity) {
+        throw std::invalid_argument("make_workload: prefill plus outstanding adds exceed the queue capacity");
+    }
+    return w;
+}
+
+// every thread's sequence keeps its removes covered (see above)
+static inline bool workload_balanced(const Workload &w) {
+    size_t threads = w.threads();
+    for (size_t t = 0; t < threads; ++t) {
+        size_t credit = w.prefill / threads + (t < w.prefill % threads ? 1 : 0);
+        if (!check_bits(w.ops[t], credit)) return false;
+    }
+    return true;
+}
+
+// Trace file: a TraceHeader, then per thread a uint64_t op count followed
+// by that many op bytes. Native byte order; meant for replay on the same
+// kind of machine.
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t seed;
+    double ratio;
+    uint64_t prefill;
+    uint64_t threads;
+};
+
+const char TRACE_MAGIC[8] = {'Q', 'T', 'R', 'A', 'C', 'E', '\0', '\0'};
+const uint32_t TRACE_VERSION = 1;
+const uint64_t TRACE_MAX_OPS = 1ULL << 32;   // per thread
+
+static inline bool save_trace(const std::string &path, const Workload &w, std::string &err) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        err = "cannot open " + path + " for writing";
+        return false;
+    }
+    TraceHeader h;
+    std::memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+    h.version = TRACE_VERSION;
+    h.kind = static_cast<uint32_t>(w.kind);
+    h.seed = w.seed;
+    h.ratio = w.ratio;
+    h.prefill = w.prefill;
+    h.threads = w.threads();
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    for (const auto &o : w.ops) {
+        uint64_t n = o.size();
+        out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+        out.write(reinterpret_cast<const char *>(o.data()), n);
+    }
+    if (!out.flush()) {
+        err = "write to " + path + " failed";
+        return false;
+    }
+    return true;
+}
+
+// Rejects traces that are malformed, whose removes are not covered or that
+// could overfill a queue of `capacity`, as those could hang the replay,
+// and traces with more than max_threads threads.
+static inline bool load_trace(const std::string &path, size_t capacity, size_t max_threads, Workload &w,
+                              std::string &err) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        err = "cannot open " + path;
+        return false;
+    }
+    TraceHeader h;
+    if (!in.read(reinterpret_cast<char *>(&h), sizeof(h)) || std::memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) != 0) {
+        err = path + " is not a trace file";
+        return false;
+    }
+    if (h.version != TRACE_VERSION || h.kind > static_cast<uint32_t>(workload_kind::patterned) || h.threads == 0) {
+        err = path + ": unsupported trace header";
+        return false;
+    }
+    if (h.threads > max_threads) {
+        err = path + ": " + std::to_string(h.threads) + " threads, at most " + std::to_string(max_threads) +
+              " supported";
+        return false;
+    }
+
+    Workload r;
+    r.kind = static_cast<workload_kind>(h.kind);
+    r.seed = h.seed;
+    r.ratio = h.ratio;
+    r.prefill = h.prefill;
+    r.ops.resize(h.threads);
+    for (auto &o : r.ops) {
+        uint64_t n;
+        if (!in.read(reinterpret_cast<char *>(&n), sizeof(n))) {
+            err = path + ": truncated";
+            return false;
+        }
+        if (n > TRACE_MAX_OPS) {
+            err = path + ": unsupported trace header";
+            return false;
+        }
+        o.resize(n);
+        if (!in.read(reinterpret_cast<char *>(o.data()), n)) {
+            err = path + ": truncated";
+            return false;
+        }
+        if (std::any_of(o.begin(), o.end(), [](uint8_t b) { return b > 1; })) {
+            err = path + ": bad op byte";
+            return false;
+        }
+    }
+    if (!workload_balanced(r)) {
+        err = path + ": a thread removes more items than it is credited";
+        return false;
+    }
+    if (r.prefill > capacity || workload_peak_items(r) > capacity) {
+        err = path + ": prefill plus outstanding adds exceed the queue capacity";
+        return false;
+    }
+    w = std::move(r);
+    return true;
+}
+
+#endif // WORKLOAD_HPP